@@ -1,14 +1,24 @@
 #include "BitcoinExchange.hpp"
 
-BitcoinExchange::BitcoinExchange()
+BitcoinExchange::BitcoinExchange() : threads(1), strictOrder(false)
 {
 }
 
+BitcoinExchange::BitcoinExchange(const BitcoinExchange &other)
+{
+	*this = other;
+}
+
 BitcoinExchange &BitcoinExchange::operator=(const BitcoinExchange &other)
 {
 	if (this != &other)
 	{
 		database = other.database;
+		ranges = other.ranges;
+		sources = other.sources;
+		statistics = other.statistics;
+		threads = other.threads;
+		strictOrder = other.strictOrder;
 	}
 	return *this;
 }
@@ -17,7 +27,85 @@ BitcoinExchange::~BitcoinExchange()
 {
 }
 
-void BitcoinExchange::readDatabase(const std::string &filename)
+// Reads the date and the first `columns` rates of a rate file row. Cells
+// that do not parse count as 0.
+static bool parseRateRow(const char *begin, const char *end, double *rates, size_t columns, int &day)
+{
+	const char *comma = static_cast<const char *>(std::memchr(begin, ',', end - begin));
+	const char *dateEnd = comma ? comma : end;
+	const char *p = dateEnd + (comma != NULL);
+	for (size_t a = 0; a < columns; ++a)
+	{
+		while (p != end && std::isspace(static_cast<unsigned char>(*p)))
+			++p;
+		if (!parseNumber(p, end, rates[a]))
+			rates[a] = 0;
+		comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+		p = comma ? comma + 1 : end;
+	}
+	return parseDay(begin, dateEnd - begin, day);
+}
+
+static bool readAt(int fd, off_t offset, size_t length, char *buf)
+{
+	while (length > 0)
+	{
+		ssize_t n = pread(fd, buf, length, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		buf += n;
+		offset += n;
+		length -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+// Offset just past the last '\n' among the first size bytes of fd.
+static off_t completeLinesEnd(int fd, off_t size)
+{
+	char buf[4096];
+	while (size > 0)
+	{
+		size_t n = static_cast<size_t>(std::min(size, static_cast<off_t>(sizeof(buf))));
+		if (!readAt(fd, size - n, n, buf))
+			return 0;
+		for (size_t i = n; i > 0; --i)
+			if (buf[i - 1] == '\n')
+				return size - n + i;
+		size -= n;
+	}
+	return 0;
+}
+
+// Remembers where the rows of filename end, so appendRates() can later read
+// only what was added after them. The bytes just before that point are kept
+// to tell an append from a rewrite of the file.
+void BitcoinExchange::addSource(const std::string &filename, const struct stat &fileStat, const RateTable &table)
+{
+	RateSource source;
+	source.filename = filename;
+	source.firstAsset = database.assetCount() - table.assetCount();
+	source.assets = table.assetCount();
+	source.device = fileStat.st_dev;
+	source.inode = fileStat.st_ino;
+	source.lastDay = table.empty() ? INT_MIN : table.dayAt(table.size() - 1);
+	source.offset = 0;
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		source.offset = completeLinesEnd(fd, fileStat.st_size);
+		size_t length = static_cast<size_t>(std::min(source.offset, static_cast<off_t>(RateSource::FINGERPRINT)));
+		source.fingerprint.resize(length);
+		if (length > 0 && !readAt(fd, source.offset - length, length, &source.fingerprint[0]))
+			source.lastDay = INT_MIN;
+		close(fd);
+	}
+	sources.push_back(source);
+}
+
+void BitcoinExchange::readDatabase(const std::string &filename, const std::string &asset)
 {
 	struct stat fileStat; 
     if (stat(filename.c_str(), &fileStat) == 0) 
@@ -32,21 +120,62 @@ void BitcoinExchange::readDatabase(const std::string &filename)
         std::cerr << "Error: could not stat the file." << std::endl;
         return;
     }
-	std::ifstream file(filename);
-	if (!file.is_open())
+	LineReader file;
+	if (!file.open(filename))
 		throw std::runtime_error("Error 2: could not open file.");
-	std::string line;
-	std::getline(file, line);	
-	while (std::getline(file, line))
+	// The header names the rate columns: "date,exchange_rate" holds one
+	// asset, "date,BTC,ETH" two. Cells that do not parse count as 0.
+	RateTable table;
+	const char *begin;
+	const char *end;
+	if (file.next(begin, end))
+	{
+		std::vector<std::string> names;
+		const char *comma = static_cast<const char *>(std::memchr(begin, ',', end - begin));
+		while (comma)
+		{
+			const char *name = comma + 1;
+			comma = static_cast<const char *>(std::memchr(name, ',', end - name));
+			names.push_back(trim(std::string(name, comma ? comma : end)));
+		}
+		if (!names.empty())
+			table.setAssets(names);
+	}
+	std::vector<double> row(table.assetCount());
+	while (file.next(begin, end))
+	{
+		int day;
+		if (parseRateRow(begin, end, &row[0], row.size(), day))
+			table.insert(day, &row[0]);
+	}
+	table.finalize();
+	addAssets(table, asset, filename, fileStat);
+}
+
+// Adds the assets of table, read from filename, to the database, naming its
+// only asset after asset when that is not empty.
+void BitcoinExchange::addAssets(RateTable &table, const std::string &asset,
+	const std::string &filename, const struct stat &fileStat)
+{
+	if (!asset.empty())
+	{
+		if (table.assetCount() != 1)
+			throw std::runtime_error("Error: " + asset + " names a file with several rate columns.");
+		table.renameAsset(0, asset);
+	}
+	bool fresh = database.empty() && database.assetCount() == 1 && database.assetName(0).empty();
+	for (size_t a = 0; a < table.assetCount() && !fresh; ++a)
 	{
-		std::istringstream iss(line);
-		std::string date;
-		double value;
-		std::getline(iss, date, ',');
-		iss >> value;
-		database[date] = value;
+		const std::string &name = table.assetName(a);
+		if (database.assetIndex(name.data(), name.length()) >= 0)
+			throw std::runtime_error("Error: duplicate asset => " + name);
 	}
-	file.close();
+	database.merge(table);
+	addSource(filename, fileStat, table);
+	// Merging can add days to every column, so all of them are reindexed.
+	ranges.assign(database.assetCount(), RangeIndex());
+	for (size_t a = 0; a < ranges.size(); ++a)
+		ranges[a].build(database.rates(a), database.size());
 }
 
 bool BitcoinExchange::isValidDateFormat(const std::string& date) {
@@ -62,43 +191,8 @@ bool BitcoinExchange::isValidDateFormat(const std::string& date) {
 }
 
 bool BitcoinExchange::isValidDateValue(const std::string& date) {
-	int year = std::atoi(date.substr(0, 4).c_str());
-	int month = std::atoi(date.substr(5, 2).c_str());
-	int day = std::atoi(date.substr(8, 2).c_str());
-
-	time_t t = time(0);
-	tm* now = localtime(&t);
-	int currentYear = now->tm_year + 1900;
-
-	if (year < 0 || year > currentYear)
-		return false;
-
-	if (month < 1 || month > 12)
-		return false;
-
-	int daysInMonth[] = {
-		31, // January
-		28, // February (can be 29 if leap year)
-		31, // March
-		30, // April
-		31, // May
-		30, // June
-		31, // July
-		31, // August
-		30, // September
-		31, // October
-		30, // November
-		31  // December
-	};
-
-	bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-	if (isLeapYear && month == 2)
-		daysInMonth[1] = 29;
-
-	if (day < 1 || day > daysInMonth[month - 1])
-		return false;
-
-	return true;
+	int day;
+	return parseDay(date.data(), date.length(), day, calendar::currentYear());
 }
 
 std::string BitcoinExchange::trim(const std::string& str)
@@ -114,104 +208,517 @@ std::string BitcoinExchange::trim(const std::string& str)
 
 std::string BitcoinExchange::findClosestDate(const std::string& date)
 {
-	auto it = database.find(date);
-	if (it != database.end())
-		return it->first;
-
-	auto upper = database.upper_bound(date);
-	if (upper == database.begin())
-		return database.begin()->first;
-
-	auto lower = std::prev(upper);
-	if (upper == database.end())
-		return lower->first;
-
-	if (upper->first == date)
-		return upper->first;
-
-	return lower->first;
+	int day;
+	if (!parseDay(date, day))
+		return "";
+	long index = database.find(day);
+	if (index < 0)
+		return "";
+	return dayToString(database.dayAt(index));
 }
 
-void BitcoinExchange::readAndProcessInput(const std::string& filename)
+// Prices every valid line of the batch through its lookup cache, which
+// searches the table in one findBatch() call for the days it has not seen,
+// then writes the results and error messages in line order.
+void BitcoinExchange::processBatch(LineBatch &batch, OutputBuffer &out) const
 {
-	struct stat fileStat; 
-    if (stat(filename.c_str(), &fileStat) == 0) 
-    {
-        if (S_ISDIR(fileStat.st_mode)) 
-        {
-            std::cerr << "Error: the specified input is a directory, not a file." << std::endl;
-            return;
-        }
-    } else 
-    {
-        std::cerr << "Error: could not stat the file." << std::endl;
-        return;
-    }
-	std::ifstream file(filename);
-	if (!file.is_open())
-		throw std::runtime_error("Error: could not open input file.");
-	int i = 0;
-	std::string line;
-	while (std::getline(file, line))
-	{
-		if (i == 0)
+	long *indices = batch.indices();
+	RunStats &stats = batch.stats();
+	bool sample = stats.batches++ % RunStats::SAMPLE_EVERY == 0 && batch.dayCount() > 0;
+	std::chrono::steady_clock::time_point start;
+	if (sample)
+		start = std::chrono::steady_clock::now();
+	batch.cache().find(database, batch.days(), batch.dayCount(), indices);
+	if (sample)
+	{
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		stats.batchLookupSamples.push_back(static_cast<float>(elapsed.count() / static_cast<double>(batch.dayCount())));
+	}
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		const LineBatch::Entry &entry = batch.entry(i);
+		// A line naming an asset that is not loaded is malformed, whatever
+		// its value.
+		long asset = entry.assetLength == 0 ? 0 : database.assetIndex(batch.asset(entry), entry.assetLength);
+		long index = entry.status == ParsedLine::OK ? *indices++ : -1;
+		if (asset < 0 || entry.status == ParsedLine::BAD_LINE || entry.status == ParsedLine::BAD_DATE)
 		{
-			// add check if the first line is header in form: "date | value"
-			trim(line);
-			if (line != "date | value")
-				std::cerr << "Error: bad or missing header." << std::endl;
-			else
-				std::getline(file, line);
-			++i;
+			out.write(OutputBuffer::ERR, "Error: bad input => ");
+			out.write(OutputBuffer::ERR, batch.text(entry), entry.textLength);
+			out.write(OutputBuffer::ERR, "\n", 1);
+			++stats.outcomes[RunStats::BAD_INPUT];
+			continue;
 		}
-		std::istringstream iss(line);
-		std::string dateStr;
-		double value;
-		if (!std::getline(iss, dateStr, '|'))
+		if (entry.status == ParsedLine::RANGE)
 		{
-			std::cerr << "Error: bad input => " << line << std::endl;
+			++stats.outcomes[processRange(entry, static_cast<size_t>(asset), out)];
 			continue;
 		}
-		dateStr = trim(dateStr);
-		if (!(iss >> value))
+		if (entry.status == ParsedLine::NEGATIVE)
 		{
-			std::cerr << "Error: bad input => " << line << std::endl;
+			out.write(OutputBuffer::ERR, "Error: not a positive number.\n");
+			++stats.outcomes[RunStats::NOT_POSITIVE];
 			continue;
 		}
-		if (!isValidDateFormat(dateStr) || !isValidDateValue(dateStr))
+		if (entry.status == ParsedLine::TOO_LARGE)
 		{
-			std::cerr << "Error: bad input => " << dateStr << std::endl;
+			out.write(OutputBuffer::ERR, "Error: too large a number.\n");
+			++stats.outcomes[RunStats::TOO_LARGE];
 			continue;
 		}
-	    std::string remaining;
-        if (iss >> remaining) 
-        {
-            std::cerr << "Error: bad input => " << line << std::endl;
-            continue;
-        }
-		if (value < 0)
+		// NaN marks an asset loaded from a file without any rates.
+		if (index < 0 || std::isnan(database.rateAt(index, asset)))
 		{
-			std::cerr << "Error: not a positive number." << std::endl;
+			out.write(OutputBuffer::ERR, "Error: no matching date found.\n");
+			++stats.outcomes[RunStats::NO_MATCH];
 			continue;
 		}
-		if (value > 1000)
+		char date[10];
+		formatDay(database.dayAt(index), date);
+		out.write(OutputBuffer::OUT, date, 10);
+		out.write(OutputBuffer::OUT, " => ", 4);
+		out.writeDouble(OutputBuffer::OUT, entry.value);
+		out.write(OutputBuffer::OUT, " = ", 3);
+		out.writeDouble(OutputBuffer::OUT, entry.value * database.rateAt(index, asset));
+		out.write(OutputBuffer::OUT, "\n", 1);
+		++stats.outcomes[RunStats::PRICED];
+	}
+	batch.clear();
+}
+
+RunStats::Outcome BitcoinExchange::processRange(const LineBatch::Entry &entry, size_t asset, OutputBuffer &out) const
+{
+	static const char *const names[] = { "min", "max", "avg" };
+	double result;
+	if (!aggregateRates(entry.firstDay, entry.lastDay, entry.aggregate, result, asset) || std::isnan(result))
+	{
+		out.write(OutputBuffer::ERR, "Error: no matching date found.\n");
+		return RunStats::NO_MATCH;
+	}
+	char date[10];
+	formatDay(entry.firstDay, date);
+	out.write(OutputBuffer::OUT, date, 10);
+	out.write(OutputBuffer::OUT, "..", 2);
+	formatDay(entry.lastDay, date);
+	out.write(OutputBuffer::OUT, date, 10);
+	out.write(OutputBuffer::OUT, " => ", 4);
+	out.write(OutputBuffer::OUT, names[entry.aggregate], 3);
+	out.write(OutputBuffer::OUT, " = ", 3);
+	out.writeDouble(OutputBuffer::OUT, result);
+	out.write(OutputBuffer::OUT, "\n", 1);
+	return RunStats::AGGREGATED;
+}
+
+// Aggregates the rates of asset over the table rows dated from firstDay to
+// lastDay inclusive. False when no row falls in that range.
+bool BitcoinExchange::aggregateRates(int firstDay, int lastDay, RangeIndex::Aggregate aggregate,
+	double &result, size_t asset) const
+{
+	size_t begin;
+	size_t end;
+	database.rowsBetween(firstDay, lastDay, begin, end);
+	if (begin >= end)
+		return false;
+	result = ranges[asset].aggregate(aggregate, begin, end);
+	return true;
+}
+
+void BitcoinExchange::processChunk(const char *begin, const char *end, int maxYear,
+	LineBatch &batch, OutputBuffer &out) const
+{
+	while (begin != end)
+	{
+		const char *newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+		const char *lineEnd = newline ? newline : end;
+		batch.add(begin, lineEnd, maxYear);
+		if (batch.full())
+			processBatch(batch, out);
+		begin = newline ? newline + 1 : end;
+	}
+	processBatch(batch, out);
+}
+
+// Fills rates[i] with the rate of asset in effect on days[i], using the same
+// closest-earlier-date rule as the line-oriented path. Rates are NaN when no
+// table is loaded.
+void BitcoinExchange::lookupRates(const int *days, size_t count, double *rates, size_t asset) const
+{
+	long indices[LineBatch::CAPACITY];
+	for (size_t start = 0; start < count; start += LineBatch::CAPACITY)
+	{
+		size_t n = std::min(count - start, LineBatch::CAPACITY);
+		database.findBatch(days + start, n, indices);
+		for (size_t i = 0; i < n; ++i)
+			rates[start + i] = indices[i] < 0 ? std::numeric_limits<double>::quiet_NaN() : database.rateAt(indices[i], asset);
+	}
+}
+
+// Splits the input at newline boundaries into chunks that the workers claim
+// in order. Each chunk's output is buffered and replayed by this thread in
+// input order. Workers may only run a bounded window of chunks ahead of the
+// one being written, which caps the memory held in pending output.
+void BitcoinExchange::processParallel(const char *begin, const char *end, int maxYear,
+	BufferedWriter &stdoutWriter, BufferedWriter &stderrWriter)
+{
+	const size_t minChunk = 64 * 1024;
+	const size_t maxChunk = 4 * 1024 * 1024;
+	size_t chunkSize = static_cast<size_t>(end - begin) / (threads * 8);
+	chunkSize = std::max(minChunk, std::min(maxChunk, chunkSize));
+
+	std::vector<const char *> bounds(1, begin);
+	while (bounds.back() != end)
+	{
+		const char *cut = bounds.back() + std::min(chunkSize, static_cast<size_t>(end - bounds.back()));
+		const char *newline = static_cast<const char *>(std::memchr(cut, '\n', end - cut));
+		bounds.push_back(newline ? newline + 1 : end);
+	}
+	const size_t chunks = bounds.size() - 1;
+	const size_t window = threads * 2;
+
+	std::vector<OutputBuffer> slots(window);
+	std::vector<char> done(window, 0);
+	size_t nextChunk = 0;
+	size_t written = 0;
+	std::mutex mutex;
+	std::condition_variable chunkDone;
+	std::condition_variable slotFree;
+
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&]()
 		{
-			std::cerr << "Error: too large a number." << std::endl;
-			continue;
+			LineBatch batch;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				while (nextChunk < chunks && nextChunk >= written + window)
+					slotFree.wait(lock);
+				if (nextChunk >= chunks)
+				{
+					collectStats(batch);
+					return;
+				}
+				size_t chunk = nextChunk++;
+				lock.unlock();
+				processChunk(bounds[chunk], bounds[chunk + 1], maxYear, batch, slots[chunk % window]);
+				lock.lock();
+				done[chunk % window] = 1;
+				chunkDone.notify_all();
+			}
+		}));
+	}
+	for (size_t chunk = 0; chunk < chunks; ++chunk)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!done[chunk % window])
+			chunkDone.wait(lock);
+		lock.unlock();
+		slots[chunk % window].flushTo(stdoutWriter, stderrWriter, strictOrder);
+		lock.lock();
+		done[chunk % window] = 0;
+		++written;
+		slotFree.notify_all();
+	}
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+}
+
+void BitcoinExchange::readAndProcessInput(const std::string& filename)
+{
+	// "-" streams the ledger from stdin, so btc can sit in a pipeline.
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	LineReader file;
+	if (filename == "-")
+		file.openFd(STDIN_FILENO);
+	else
+	{
+		struct stat fileStat;
+		if (stat(filename.c_str(), &fileStat) == 0)
+		{
+			if (S_ISDIR(fileStat.st_mode))
+			{
+				std::cerr << "Error: the specified input is a directory, not a file." << std::endl;
+				return;
+			}
 		}
-		std::string closestDate = findClosestDate(dateStr);
-		if (closestDate.empty())
+		else
 		{
-			std::cerr << "Error: no matching date found." << std::endl;
-			continue;
+			std::cerr << "Error: could not stat the file." << std::endl;
+			return;
+		}
+		if (!file.open(filename))
+			throw std::runtime_error("Error: could not open input file.");
+	}
+	int maxYear = calendar::currentYear();
+	// The asset column is optional; lines without one use the first asset.
+	static const std::string headers[2] = { "date | value", "date | value | asset" };
+	BufferedWriter stdoutWriter(STDOUT_FILENO);
+	BufferedWriter stderrWriter(STDERR_FILENO);
+	OutputBuffer out;
+	LineBatch batch;
+	const char *begin;
+	const char *end;
+	if (file.next(begin, end))
+	{
+		const std::string *header = headers;
+		while (header != headers + 2 && header->compare(0, std::string::npos, begin, end - begin) != 0)
+			++header;
+		if (header == headers + 2)
+			out.write(OutputBuffer::ERR, "Error: bad or missing header.\n");
+		else if (!file.next(begin, end))
+		{
+			// Like std::getline, a header that ends the file is followed by
+			// an empty line only if it was terminated by a newline.
+			begin = header->data();
+			end = file.hadNewline() ? begin : begin + header->length();
+		}
+		batch.add(begin, end, maxYear);
+	}
+	if (threads > 1 && file.remaining(begin, end))
+	{
+		processBatch(batch, out);
+		out.flushTo(stdoutWriter, stderrWriter, strictOrder);
+		processParallel(begin, end, maxYear, stdoutWriter, stderrWriter);
+		finishRun(batch, stdoutWriter, stderrWriter, start);
+		return;
+	}
+	while (true)
+	{
+		// Output is handed to the writers a batch at a time and only pushed
+		// to the descriptors when they fill up, at the end, or when the
+		// input has nothing more buffered and the next read would block.
+		bool more = file.next(begin, end);
+		if (more)
+			batch.add(begin, end, maxYear);
+		if (batch.full() || !more || !file.hasLine())
+		{
+			processBatch(batch, out);
+			out.flushTo(stdoutWriter, stderrWriter, strictOrder);
+			if (more && !file.hasLine())
+			{
+				stdoutWriter.flush();
+				stderrWriter.flush();
+			}
+		}
+		if (!more)
+			break;
+	}
+	finishRun(batch, stdoutWriter, stderrWriter, start);
+}
+
+// Flushes the output and folds the counters of batch into the statistics.
+void BitcoinExchange::finishRun(LineBatch &batch, BufferedWriter &stdoutWriter, BufferedWriter &stderrWriter,
+	std::chrono::steady_clock::time_point start)
+{
+	stdoutWriter.flush();
+	stderrWriter.flush();
+	collectStats(batch);
+	statistics.processSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BitcoinExchange::collectStats(LineBatch &batch)
+{
+	statistics.merge(batch.stats());
+	statistics.cacheHits += batch.cache().hits();
+	statistics.cacheMisses += batch.cache().misses();
+}
+
+long BitcoinExchange::assetIndex(const std::string &name) const
+{
+	return database.assetIndex(name.data(), name.length());
+}
+
+size_t BitcoinExchange::rateCount() const
+{
+	return database.size();
+}
+
+void BitcoinExchange::setThreads(unsigned int count)
+{
+	threads = count > 0 ? count : 1;
+}
+
+// Uses the binary snapshot of filename when it is present and was built from
+// the CSV as it is now; otherwise parses the CSV itself.
+void BitcoinExchange::loadRates(const std::string &filename, const std::string &asset)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	struct stat fileStat;
+	RateTable table;
+	if (stat(filename.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)
+		&& loadSnapshot(snapshotPath(filename), fileStat, table))
+		addAssets(table, asset, filename, fileStat);
+	else
+		readDatabase(filename, asset);
+	statistics.loadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Ingests the rows appended to the rate files since they were loaded, without
+// parsing them again from the start. Returns the number of rows read, or -1
+// when a file was replaced or changed other than by appending rows in date
+// order. The rates then have to be loaded again from scratch, since this
+// exchange may already hold part of the new rows.
+long BitcoinExchange::appendRates()
+{
+	long rows = 0;
+	for (size_t s = 0; s < sources.size(); ++s)
+	{
+		RateSource &source = sources[s];
+		int fd = open(source.filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			return -1;
+		struct stat fileStat;
+		std::string fingerprint(source.fingerprint.size(), '\0');
+		std::vector<char> tail;
+		bool appended = fstat(fd, &fileStat) == 0 && fileStat.st_dev == source.device
+			&& fileStat.st_ino == source.inode && fileStat.st_size >= source.offset
+			&& (fingerprint.empty() || readAt(fd, source.offset - fingerprint.size(), fingerprint.size(), &fingerprint[0]))
+			&& fingerprint == source.fingerprint;
+		if (appended && fileStat.st_size > source.offset)
+		{
+			tail.resize(static_cast<size_t>(fileStat.st_size - source.offset));
+			appended = readAt(fd, source.offset, tail.size(), &tail[0]);
 		}
-		std::cout << closestDate << " => " << value << " = " << value * database[closestDate] << std::endl;
+		close(fd);
+		if (!appended)
+			return -1;
+
+		// Only complete lines are taken; a row still being written is read
+		// on the next call.
+		const char *begin = tail.empty() ? NULL : &tail[0];
+		const char *end = begin + tail.size();
+		while (end != begin && end[-1] != '\n')
+			--end;
+		std::vector<double> row(source.assets);
+		for (const char *line = begin; line != end; )
+		{
+			const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+			int day;
+			if (parseRateRow(line, newline, &row[0], row.size(), day))
+			{
+				if (source.lastDay == INT_MIN || day < database.dayAt(database.size() - 1))
+					return -1;
+				bool newRow = day > database.dayAt(database.size() - 1);
+				database.appendRow(day, source.firstAsset, &row[0], row.size());
+				for (size_t a = 0; a < ranges.size(); ++a)
+				{
+					bool changed = a >= source.firstAsset && a < source.firstAsset + source.assets;
+					if (!newRow && changed)
+						ranges[a].pop();
+					if (newRow || changed)
+						ranges[a].push(database.rateAt(database.size() - 1, a));
+				}
+				source.lastDay = day;
+				++rows;
+			}
+			line = newline + 1;
+		}
+		source.fingerprint.append(begin, end);
+		if (source.fingerprint.size() > RateSource::FINGERPRINT)
+			source.fingerprint.erase(0, source.fingerprint.size() - RateSource::FINGERPRINT);
+		source.offset += end - begin;
 	}
-	file.close();
+	return rows;
+}
+
+void BitcoinExchange::buildSnapshot(const std::string &filename)
+{
+	struct stat fileStat;
+	if (stat(filename.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+		throw std::runtime_error("Error: could not stat the file.");
+	database.clear();
+	sources.clear();
+	readDatabase(filename);
+	writeSnapshot(database, snapshotPath(filename), fileStat);
+	std::cout << snapshotPath(filename) << ": " << database.size() << " rates" << std::endl;
+}
+
+void BitcoinExchange::checkSnapshot(const std::string &filename)
+{
+	std::string path = snapshotPath(filename);
+	verifySnapshot(path);
+	struct stat fileStat;
+	bool fresh = stat(filename.c_str(), &fileStat) == 0 && loadSnapshot(path, fileStat, database);
+	std::cout << path << ": valid, " << (fresh ? "up to date" : "stale") << std::endl;
+}
+
+const RunStats &BitcoinExchange::stats() const
+{
+	return statistics;
+}
+
+void BitcoinExchange::writeStats(std::ostream &out, bool json) const
+{
+	static const char *const names[RunStats::OUTCOMES] = {
+		"priced", "aggregated", "bad_input", "not_positive", "too_large", "no_match"
+	};
+	static const char *const labels[RunStats::OUTCOMES] = {
+		"priced", "range queries", "bad input", "not a positive number", "too large a number", "no matching date"
+	};
+	size_t tableBytes = database.size() * (sizeof(int) + database.assetCount() * sizeof(double));
+	size_t indexBytes = 0;
+	for (size_t a = 0; a < ranges.size(); ++a)
+		indexBytes += ranges[a].bytes();
+	struct rusage usage;
+	long maxRss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+	unsigned long lines = statistics.lines();
+	double linesPerSecond = statistics.processSeconds > 0 ? lines / statistics.processSeconds : 0;
+	unsigned long lookups = statistics.cacheHits + statistics.cacheMisses;
+	double hitRate = lookups > 0 ? 100.0 * statistics.cacheHits / lookups : 0;
+	static const double percentiles[] = { 50, 90, 99, 100 };
+	static const char *const percentileNames[] = { "p50", "p90", "p99", "max" };
+
+	std::ostream::fmtflags flags = out.flags();
+	if (json)
+	{
+		out << "{\"load_seconds\": " << statistics.loadSeconds
+			<< ", \"process_seconds\": " << statistics.processSeconds
+			<< ", \"lines\": " << lines
+			<< ", \"lines_per_second\": " << std::fixed << std::setprecision(0) << linesPerSecond;
+		out.flags(flags);
+		out << std::setprecision(6) << ", \"outcomes\": {";
+		for (int i = 0; i < RunStats::OUTCOMES; ++i)
+			out << (i ? ", \"" : "\"") << names[i] << "\": " << statistics.outcomes[i];
+		out << "}, \"rows\": " << database.size()
+			<< ", \"assets\": " << database.assetCount()
+			<< ", \"table_bytes\": " << tableBytes
+			<< ", \"index_bytes\": " << indexBytes
+			<< ", \"max_rss_kib\": " << maxRss
+			<< ", \"cache_hits\": " << statistics.cacheHits
+			<< ", \"cache_misses\": " << statistics.cacheMisses
+			<< ", \"batch_avg_lookup_ns\": {";
+		for (int i = 0; i < 4; ++i)
+			out << (i ? ", \"" : "\"") << percentileNames[i] << "\": " << statistics.batchLookupPercentile(percentiles[i]);
+		out << "}, \"batch_avg_lookup_samples\": " << statistics.batchLookupSamples.size() << "}" << std::endl;
+		return;
+	}
+	out << "btc stats:" << std::endl
+		<< "  load rates      " << statistics.loadSeconds << " s" << std::endl
+		<< "  process input   " << statistics.processSeconds << " s, " << lines << " lines ("
+		<< std::fixed << std::setprecision(0) << linesPerSecond << " lines/s)" << std::endl;
+	out.flags(flags);
+	out << std::setprecision(6);
+	for (int i = 0; i < RunStats::OUTCOMES; ++i)
+		out << "  " << std::left << std::setw(22) << labels[i] << std::right << statistics.outcomes[i] << std::endl;
+	out << "  rate table      " << database.size() << " rows x " << database.assetCount() << " assets, "
+		<< tableBytes << " bytes (+" << indexBytes << " bytes range index)" << std::endl
+		<< "  max RSS         " << maxRss << " KiB" << std::endl
+		<< "  lookup cache    " << statistics.cacheHits << " hits, " << statistics.cacheMisses << " misses ("
+		<< hitRate << "%)" << std::endl
+		<< "  batch avg lookup";
+	for (int i = 0; i < 4; ++i)
+		out << " " << percentileNames[i] << " " << statistics.batchLookupPercentile(percentiles[i]) << " ns";
+	out << " (" << statistics.batchLookupSamples.size() << " sampled batches)" << std::endl;
+}
+
+void BitcoinExchange::setStrictOrder(bool strict)
+{
+	strictOrder = strict;
 }
 
 void BitcoinExchange::run(const std::string &filename)
 {
-	readDatabase("data.csv");
+	loadRates("data.csv");
 	readAndProcessInput(filename);
 }
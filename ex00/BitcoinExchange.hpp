@@ -10,27 +10,105 @@
 #include <algorithm>
 #include <exception>
 #include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <regex>
 #include <ctime>
 #include <climits>
+#include <limits>
 #include <cstdlib>
 #include <cctype>
 #include <vector>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "RateTable.hpp"
+#include "Date.hpp"
+#include "LineParser.hpp"
+#include "LineReader.hpp"
+#include "OutputBuffer.hpp"
+#include "BufferedWriter.hpp"
+#include "RateSnapshot.hpp"
+#include "LineBatch.hpp"
+#include "RangeIndex.hpp"
+#include "RunStats.hpp"
 
 class BitcoinExchange
 {
 public:
 	BitcoinExchange();
+	BitcoinExchange(const BitcoinExchange &other);
 	BitcoinExchange &operator=(const BitcoinExchange &other);
 	~BitcoinExchange();
-	void readDatabase(const std::string &filename);
+	// Both add the rate columns of filename to the ones already loaded,
+	// naming a single-column file's asset after asset when it is given.
+	void readDatabase(const std::string &filename, const std::string &asset = "");
+	void loadRates(const std::string &filename, const std::string &asset = "");
+	long appendRates();
+	void buildSnapshot(const std::string &filename);
+	void checkSnapshot(const std::string &filename);
 	void readAndProcessInput(const std::string &filename);
 	void run(const std::string &filename);
+	void setThreads(unsigned int threads);
+	// Keep stdout and stderr lines in their original relative order, at
+	// the cost of flushing whenever output switches between the two.
+	void setStrictOrder(bool strict);
 	bool isValidDateValue(const std::string& date);
 	bool isValidDateFormat(const std::string& date);
 	std::string findClosestDate(const std::string& date);
+	void lookupRates(const int *days, size_t count, double *rates, size_t asset = 0) const;
+	long assetIndex(const std::string &name) const;
+	// Minimum, maximum or average rate of asset over the rows dated from
+	// firstDay to lastDay inclusive, in O(1). False if no row is in range.
+	bool aggregateRates(int firstDay, int lastDay, RangeIndex::Aggregate aggregate,
+		double &result, size_t asset = 0) const;
+	size_t rateCount() const;
+	// Prices the lines of batch and writes btc's output for them to out.
+	void processBatch(LineBatch &batch, OutputBuffer &out) const;
 	std::string trim(const std::string& str);
+	const RunStats &stats() const;
+	// Writes the --stats report: timings, outcome counts, table and index
+	// sizes, lookup cache figures and sampled per-batch average lookup times,
+	// as text or as JSON.
+	void writeStats(std::ostream &out, bool json) const;
 
 private:
-	std::map<std::string, double> database;
+	// A rate file loaded into the database and how far it has been read.
+	struct RateSource
+	{
+		static const size_t FINGERPRINT = 64;
+
+		std::string filename;
+		size_t firstAsset;
+		size_t assets;
+		dev_t device;
+		ino_t inode;
+		off_t offset;
+		std::string fingerprint;
+		int lastDay;	// INT_MIN while the file has no rows
+	};
+
+	void addAssets(RateTable &table, const std::string &asset,
+		const std::string &filename, const struct stat &fileStat);
+	void addSource(const std::string &filename, const struct stat &fileStat, const RateTable &table);
+	RunStats::Outcome processRange(const LineBatch::Entry &entry, size_t asset, OutputBuffer &out) const;
+	void processChunk(const char *begin, const char *end, int maxYear,
+		LineBatch &batch, OutputBuffer &out) const;
+	void finishRun(LineBatch &batch, BufferedWriter &stdoutWriter, BufferedWriter &stderrWriter,
+		std::chrono::steady_clock::time_point start);
+	void collectStats(LineBatch &batch);
+	void processParallel(const char *begin, const char *end, int maxYear,
+		BufferedWriter &stdoutWriter, BufferedWriter &stderrWriter);
+
+	RateTable database;
+	std::vector<RangeIndex> ranges;
+	std::vector<RateSource> sources;
+	RunStats statistics;
+	unsigned int threads;
+	bool strictOrder;
 };
\ No newline at end of file
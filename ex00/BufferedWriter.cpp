@@ -0,0 +1,61 @@
+#include "BufferedWriter.hpp"
+
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+const size_t BufferedWriter::DEFAULT_CAPACITY;
+
+BufferedWriter::BufferedWriter(int fd, size_t capacity) : _fd(fd), _buffer(capacity), _used(0)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+	flush();
+}
+
+void BufferedWriter::write(const char *data, size_t length)
+{
+	if (_used + length > _buffer.size())
+	{
+		flush();
+		// Blocks at least as large as the buffer skip the copy.
+		if (length >= _buffer.size())
+		{
+			writeAll(data, length);
+			return;
+		}
+	}
+	std::memcpy(&_buffer[0] + _used, data, length);
+	_used += length;
+}
+
+void BufferedWriter::flush()
+{
+	if (_used == 0)
+		return;
+	writeAll(&_buffer[0], _used);
+	_used = 0;
+}
+
+bool BufferedWriter::pending() const
+{
+	return _used > 0;
+}
+
+// Output that cannot be written (closed pipe, full disk) is dropped, the
+// same way a failed std::ostream would drop it.
+void BufferedWriter::writeAll(const char *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t n = ::write(_fd, data, length);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return;
+		data += n;
+		length -= static_cast<size_t>(n);
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Accumulates output for one file descriptor and hands it to write(2) in
+// large blocks: when the buffer fills up, on flush(), and on destruction.
+class BufferedWriter
+{
+public:
+	static const size_t DEFAULT_CAPACITY = 256 * 1024;
+
+	explicit BufferedWriter(int fd, size_t capacity = DEFAULT_CAPACITY);
+	~BufferedWriter();
+
+	void write(const char *data, size_t length);
+	void flush();
+	bool pending() const;
+
+private:
+	BufferedWriter(const BufferedWriter &other);
+	BufferedWriter &operator=(const BufferedWriter &other);
+
+	void writeAll(const char *data, size_t length);
+
+	int _fd;
+	std::vector<char> _buffer;
+	size_t _used;
+};
@@ -0,0 +1,87 @@
+#include "Date.hpp"
+
+#include <ctime>
+
+int calendar::currentYear()
+{
+	static const int year = []()
+	{
+		time_t t = time(0);
+		return localtime(&t)->tm_year + 1900;
+	}();
+	return year;
+}
+
+int daysFromCivil(int year, int month, int day)
+{
+	return calendar::ordinal(year, month, day);
+}
+
+// The inverse follows the era-based algorithm: shift the year so it starts
+// in March, which puts the leap day at the end and makes the month lengths
+// a linear function of the month index.
+void civilFromDays(int days, int &year, int &month, int &day)
+{
+	days += 719468;
+	const int era = (days >= 0 ? days : days - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(days - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+	day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+	month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+	year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+}
+
+bool parseDay(const char *date, size_t length, int &days, int maxYear)
+{
+	if (length != 10 || date[4] != '-' || date[7] != '-')
+		return false;
+	unsigned int digits[8];
+	static const int positions[8] = { 0, 1, 2, 3, 5, 6, 8, 9 };
+	unsigned int bad = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		digits[i] = static_cast<unsigned char>(date[positions[i]]) - '0';
+		bad |= digits[i] > 9;
+	}
+	if (bad)
+		return false;
+	int year = static_cast<int>(digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3]);
+	int month = static_cast<int>(digits[4] * 10 + digits[5]);
+	int day = static_cast<int>(digits[6] * 10 + digits[7]);
+	if (year > maxYear || month < 1 || month > 12 || day < 1 || day > calendar::daysInMonth(year, month))
+		return false;
+	days = calendar::ordinal(year, month, day);
+	return true;
+}
+
+bool parseDay(const std::string &date, int &days)
+{
+	return parseDay(date.data(), date.length(), days);
+}
+
+void formatDay(int days, char *out)
+{
+	int year;
+	int month;
+	int day;
+	civilFromDays(days, year, month, day);
+	out[0] = static_cast<char>('0' + year / 1000 % 10);
+	out[1] = static_cast<char>('0' + year / 100 % 10);
+	out[2] = static_cast<char>('0' + year / 10 % 10);
+	out[3] = static_cast<char>('0' + year % 10);
+	out[4] = '-';
+	out[5] = static_cast<char>('0' + month / 10);
+	out[6] = static_cast<char>('0' + month % 10);
+	out[7] = '-';
+	out[8] = static_cast<char>('0' + day / 10);
+	out[9] = static_cast<char>('0' + day % 10);
+}
+
+std::string dayToString(int days)
+{
+	char buf[10];
+	formatDay(days, buf);
+	return std::string(buf, 10);
+}
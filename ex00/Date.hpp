@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+
+// Dates are handled as day ordinals: the number of days since 1970-01-01 in
+// the proleptic Gregorian calendar. Ordinals compare like the dates they
+// encode, so the rate table can be searched with plain integer comparisons.
+
+namespace calendar
+{
+	constexpr bool isLeapYear(int year)
+	{
+		return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	}
+
+	// Days before the first of each month (index 1..12, plus the year length
+	// at 13), for common and leap years.
+	constexpr int DAYS_BEFORE_MONTH[2][14] = {
+		{ 0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+		{ 0, 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+	};
+
+	// Days from 0001-01-01 to January 1st of year (proleptic Gregorian), so
+	// daysBeforeYear(1) == 0. The year is shifted by one 400-year cycle so the
+	// divisions never see a negative operand.
+	constexpr int daysBeforeYear(int year)
+	{
+		return 365 * (year + 399) + (year + 399) / 4 - (year + 399) / 100 + (year + 399) / 400 - 146097;
+	}
+
+	constexpr int EPOCH = daysBeforeYear(1970);
+
+	// Days since 1970-01-01, the day numbers stored in tables and snapshots.
+	constexpr int ordinal(int year, int month, int day)
+	{
+		return daysBeforeYear(year) - EPOCH + DAYS_BEFORE_MONTH[isLeapYear(year)][month] + day - 1;
+	}
+
+	constexpr int daysInMonth(int year, int month)
+	{
+		return DAYS_BEFORE_MONTH[isLeapYear(year)][month + 1] - DAYS_BEFORE_MONTH[isLeapYear(year)][month];
+	}
+
+	// Year of the local clock. The clock is read once per process.
+	int currentYear();
+}
+
+int daysFromCivil(int year, int month, int day);
+void civilFromDays(int days, int &year, int &month, int &day);
+
+// Validates a strict "YYYY-MM-DD" date with a real month/day, no later than
+// maxYear, and encodes it as an ordinal in the same pass.
+bool parseDay(const char *date, size_t length, int &days, int maxYear = 9999);
+bool parseDay(const std::string &date, int &days);
+
+// Writes the "YYYY-MM-DD" form of an ordinal into out (10 chars, no NUL).
+void formatDay(int days, char *out);
+std::string dayToString(int days);
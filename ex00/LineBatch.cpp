@@ -0,0 +1,106 @@
+#include "LineBatch.hpp"
+
+const size_t LineBatch::CAPACITY;
+
+LineBatch::LineBatch()
+{
+	_entries.reserve(CAPACITY);
+	_days.reserve(CAPACITY);
+	_indices.resize(CAPACITY);
+}
+
+void LineBatch::add(const char *begin, const char *end, int maxYear)
+{
+	ParsedLine parsed;
+	parseLine(begin, end, maxYear, parsed);
+	Entry entry = { parsed.status, parsed.value, 0, 0, RangeIndex::AVG, _text.size(), 0, 0 };
+	if (parsed.status == ParsedLine::RANGE)
+	{
+		entry.firstDay = parsed.day;
+		entry.lastDay = parsed.lastDay;
+		entry.aggregate = parsed.aggregate;
+	}
+	if (parsed.status == ParsedLine::OK)
+		_days.push_back(parsed.day);
+	if (parsed.status != ParsedLine::BAD_LINE && parsed.status != ParsedLine::BAD_DATE && parsed.assetLength > 0)
+	{
+		// The line is kept too: naming an unknown asset is reported as bad input.
+		entry.textLength = static_cast<size_t>(end - begin);
+		entry.assetLength = parsed.assetLength;
+		_text.insert(_text.end(), begin, end);
+		_text.insert(_text.end(), parsed.asset, parsed.asset + parsed.assetLength);
+	}
+	else if (parsed.status == ParsedLine::BAD_LINE)
+	{
+		entry.textLength = static_cast<size_t>(end - begin);
+		_text.insert(_text.end(), begin, end);
+	}
+	else if (parsed.status == ParsedLine::BAD_DATE)
+	{
+		entry.textLength = parsed.dateLength;
+		_text.insert(_text.end(), parsed.date, parsed.date + parsed.dateLength);
+	}
+	_entries.push_back(entry);
+}
+
+void LineBatch::clear()
+{
+	_entries.clear();
+	_days.clear();
+	_text.clear();
+}
+
+bool LineBatch::full() const
+{
+	return _entries.size() >= CAPACITY;
+}
+
+bool LineBatch::empty() const
+{
+	return _entries.empty();
+}
+
+size_t LineBatch::size() const
+{
+	return _entries.size();
+}
+
+const LineBatch::Entry &LineBatch::entry(size_t i) const
+{
+	return _entries[i];
+}
+
+const char *LineBatch::text(const Entry &entry) const
+{
+	return _text.empty() ? "" : &_text[0] + entry.textOffset;
+}
+
+const char *LineBatch::asset(const Entry &entry) const
+{
+	return text(entry) + entry.textLength;
+}
+
+const int *LineBatch::days() const
+{
+	return _days.empty() ? NULL : &_days[0];
+}
+
+size_t LineBatch::dayCount() const
+{
+	return _days.size();
+}
+
+long *LineBatch::indices()
+{
+	return &_indices[0];
+}
+
+LookupCache &LineBatch::cache()
+{
+	return _cache;
+}
+
+RunStats &LineBatch::stats()
+{
+	return _stats;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "LineParser.hpp"
+#include "LookupCache.hpp"
+#include "RunStats.hpp"
+
+// A block of parsed input lines waiting to be priced together. Valid lines
+// contribute their day ordinal to days(), so the whole block can be resolved
+// with one RateTable::findBatch() call. Error lines keep a copy of the text
+// their message quotes, and valid lines naming an asset a copy of the line, which
+// lets the batch outlive the line views it was filled from. Each worker fills
+// its own batch, which therefore also carries the worker's lookup cache and
+// statistics.
+class LineBatch
+{
+public:
+	static const size_t CAPACITY = 256;
+
+	struct Entry
+	{
+		ParsedLine::Status status;
+		double value;
+		int firstDay;	// bounds and aggregate of RANGE entries
+		int lastDay;
+		RangeIndex::Aggregate aggregate;
+		size_t textOffset;
+		size_t textLength;
+		size_t assetLength;	// 0 when the line names no asset
+	};
+
+	LineBatch();
+
+	void add(const char *begin, const char *end, int maxYear);
+	void clear();
+	bool full() const;
+	bool empty() const;
+	size_t size() const;
+
+	const Entry &entry(size_t i) const;
+	const char *text(const Entry &entry) const;
+	const char *asset(const Entry &entry) const;
+	// Day ordinals of the OK entries, in order, and where to put their answers.
+	const int *days() const;
+	size_t dayCount() const;
+	long *indices();
+	LookupCache &cache();
+	RunStats &stats();
+
+private:
+	std::vector<Entry> _entries;
+	std::vector<int> _days;
+	std::vector<long> _indices;
+	std::vector<char> _text;
+	LookupCache _cache;
+	RunStats _stats;
+};
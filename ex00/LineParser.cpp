@@ -0,0 +1,177 @@
+#include "LineParser.hpp"
+#include "Date.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Mirrors the grammar std::num_get uses for floating point input: optional
+// sign, leading zeros collapsed into one, digits with at most one decimal
+// point, then an optional exponent. The collected text is converted with
+// strtod and rejected unless it is consumed completely and finite.
+bool parseNumber(const char *&p, const char *end, double &value)
+{
+	char buf[128];
+	size_t len = 0;
+	bool foundMantissa = false;
+	bool foundDec = false;
+	bool foundSci = false;
+
+	if (p != end && (*p == '+' || *p == '-'))
+		buf[len++] = *p++;
+	while (p != end && *p == '0')
+	{
+		if (!foundMantissa)
+			buf[len++] = '0';
+		foundMantissa = true;
+		++p;
+	}
+	const char *body = p;
+	while (p != end)
+	{
+		if (isDigit(*p))
+			foundMantissa = true;
+		else if (*p == '.' && !foundDec && !foundSci)
+			foundDec = true;
+		else if ((*p == 'e' || *p == 'E') && !foundSci && foundMantissa)
+		{
+			foundSci = true;
+			if (p + 1 != end && (p[1] == '+' || p[1] == '-'))
+				++p;
+		}
+		else
+			break;
+		++p;
+	}
+
+	// Only absurdly long numbers need the heap.
+	std::string longText;
+	const char *text = buf;
+	size_t bodyLength = static_cast<size_t>(p - body);
+	if (len + bodyLength < sizeof(buf))
+	{
+		std::copy(body, p, buf + len);
+		buf[len + bodyLength] = '\0';
+	}
+	else
+	{
+		longText.assign(buf, len);
+		longText.append(body, p);
+		text = longText.c_str();
+	}
+	char *stop;
+	value = std::strtod(text, &stop);
+	if (stop == text || *stop != '\0')
+		return false;
+	if (value == std::numeric_limits<double>::infinity() || value == -std::numeric_limits<double>::infinity())
+		return false;
+	return true;
+}
+
+// Accepts what may follow the value: nothing, or "| asset".
+static bool parseAsset(const char *p, const char *end, ParsedLine &out)
+{
+	while (p != end && isSpace(*p))
+		++p;
+	if (p == end)
+		return true;
+	if (*p != '|')
+		return false;
+	const char *assetBegin = p + 1;
+	const char *assetEnd = end;
+	while (assetBegin != assetEnd && isSpace(*assetBegin))
+		++assetBegin;
+	while (assetEnd != assetBegin && isSpace(assetEnd[-1]))
+		--assetEnd;
+	for (p = assetBegin; p != assetEnd && *p != '|'; ++p)
+		;
+	if (assetBegin == assetEnd || p != assetEnd)
+		return false;
+	out.asset = assetBegin;
+	out.assetLength = static_cast<size_t>(assetEnd - assetBegin);
+	return true;
+}
+
+// "FROM..TO | aggregate". Anything that does not take this shape stays a bad
+// line, as it was before range queries existed.
+static void parseRange(const char *p, const char *end, int maxYear, ParsedLine &out)
+{
+	static const char *const names[] = { "min", "max", "avg" };
+	static const RangeIndex::Aggregate aggregates[] = { RangeIndex::MIN, RangeIndex::MAX, RangeIndex::AVG };
+	size_t i = 0;
+	while (i < 3 && !(end - p >= 3 && p[0] == names[i][0] && p[1] == names[i][1] && p[2] == names[i][2]))
+		++i;
+	if (i == 3 || (p + 3 != end && !isSpace(p[3]) && p[3] != '|') || !parseAsset(p + 3, end, out))
+		return;
+	const char *dots = out.date;
+	const char *dateEnd = out.date + out.dateLength;
+	while (dots + 1 < dateEnd && !(dots[0] == '.' && dots[1] == '.'))
+		++dots;
+	if (dots + 1 >= dateEnd)
+		return;
+	out.aggregate = aggregates[i];
+	if (!parseDay(out.date, static_cast<size_t>(dots - out.date), out.day, maxYear)
+		|| !parseDay(dots + 2, static_cast<size_t>(dateEnd - dots - 2), out.lastDay, maxYear)
+		|| out.day > out.lastDay)
+	{
+		out.status = ParsedLine::BAD_DATE;
+		return;
+	}
+	out.status = ParsedLine::RANGE;
+}
+
+void parseLine(const char *begin, const char *end, int maxYear, ParsedLine &out)
+{
+	out.status = ParsedLine::BAD_LINE;
+	out.assetLength = 0;
+	if (begin == end)
+		return;
+
+	const char *bar = begin;
+	while (bar != end && *bar != '|')
+		++bar;
+	const char *dateBegin = begin;
+	const char *dateEnd = bar;
+	while (dateBegin != dateEnd && (*dateBegin == ' ' || *dateBegin == '\t'))
+		++dateBegin;
+	while (dateEnd != dateBegin && (dateEnd[-1] == ' ' || dateEnd[-1] == '\t'))
+		--dateEnd;
+	out.date = dateBegin;
+	out.dateLength = static_cast<size_t>(dateEnd - dateBegin);
+	if (bar == end)
+		return;
+
+	const char *p = bar + 1;
+	while (p != end && isSpace(*p))
+		++p;
+	const char *field = p;
+	if (!parseNumber(p, end, out.value))
+	{
+		parseRange(field, end, maxYear, out);
+		return;
+	}
+	if (!parseDay(out.date, out.dateLength, out.day, maxYear))
+	{
+		out.status = ParsedLine::BAD_DATE;
+		return;
+	}
+	if (!parseAsset(p, end, out))
+		return;
+	if (out.value < 0)
+		out.status = ParsedLine::NEGATIVE;
+	else if (out.value > 1000)
+		out.status = ParsedLine::TOO_LARGE;
+	else
+		out.status = ParsedLine::OK;
+}
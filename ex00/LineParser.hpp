@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include "RangeIndex.hpp"
+
+// Result of decoding one "YYYY-MM-DD | value" input line, optionally followed
+// by "| asset" to price it in something other than the first asset. A line
+// "YYYY-MM-DD..YYYY-MM-DD | min|max|avg" asks for an aggregate of the rates
+// between the two dates instead; day and lastDay hold its bounds. Parsing
+// works on a [begin, end) character span and never allocates; date and asset
+// point back into the span so they can be quoted without copying.
+struct ParsedLine
+{
+	enum Status
+	{
+		OK,
+		RANGE,
+		BAD_LINE,	// "Error: bad input => <line>"
+		BAD_DATE,	// "Error: bad input => <date>"
+		NEGATIVE,	// "Error: not a positive number."
+		TOO_LARGE	// "Error: too large a number."
+	};
+
+	Status status;
+	const char *date;
+	size_t dateLength;
+	int day;
+	int lastDay;
+	RangeIndex::Aggregate aggregate;
+	double value;
+	const char *asset;
+	size_t assetLength;	// 0 when the line names no asset
+};
+
+// Parses a floating point number the way operator>>(double&) does in the
+// "C" locale, advancing p past the characters it consumed.
+bool parseNumber(const char *&p, const char *end, double &value);
+
+void parseLine(const char *begin, const char *end, int maxYear, ParsedLine &out);
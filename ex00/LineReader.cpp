@@ -0,0 +1,227 @@
+#include "LineReader.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const size_t LineReader::RING_SIZE;
+
+LineReader::LineReader()
+	: _fd(-1), _ownsFd(false), _map(NULL), _mapSize(0), _offset(0),
+	  _head(0), _tail(0), _scanned(0), _skipping(false), _eof(false), _hadNewline(false)
+{
+}
+
+LineReader::~LineReader()
+{
+	close();
+}
+
+bool LineReader::open(const std::string &filename)
+{
+	close();
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0)
+	{
+		void *map = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			madvise(map, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+			_map = static_cast<const char *>(map);
+			_mapSize = static_cast<size_t>(fileStat.st_size);
+			_fd = fd;
+			_ownsFd = true;
+			return true;
+		}
+	}
+	openFd(fd);
+	_ownsFd = true;
+	return true;
+}
+
+void LineReader::openFd(int fd)
+{
+	close();
+	_fd = fd;
+	_ring.resize(RING_SIZE);
+	_line.resize(RING_SIZE);
+}
+
+void LineReader::close()
+{
+	if (_map)
+		munmap(const_cast<char *>(_map), _mapSize);
+	if (_fd >= 0 && _ownsFd)
+		::close(_fd);
+	_fd = -1;
+	_ownsFd = false;
+	_map = NULL;
+	_mapSize = 0;
+	_offset = 0;
+	_ring.clear();
+	_line.clear();
+	_head = 0;
+	_tail = 0;
+	_scanned = 0;
+	_skipping = false;
+	_eof = false;
+	_hadNewline = false;
+}
+
+bool LineReader::next(const char *&begin, const char *&end)
+{
+	if (_map)
+		return nextMapped(begin, end);
+	if (_fd < 0)
+		return false;
+	return nextStreamed(begin, end);
+}
+
+bool LineReader::nextMapped(const char *&begin, const char *&end)
+{
+	if (_offset >= _mapSize)
+		return false;
+	begin = _map + _offset;
+	const char *newline = static_cast<const char *>(std::memchr(begin, '\n', _mapSize - _offset));
+	_hadNewline = newline != NULL;
+	end = _hadNewline ? newline : _map + _mapSize;
+	_offset = static_cast<size_t>(end - _map) + _hadNewline;
+	return true;
+}
+
+// Looks for '\n' in the unscanned part of the ring, which may wrap around.
+bool LineReader::findNewline(size_t &position) const
+{
+	size_t from = _scanned;
+	while (from < _tail)
+	{
+		size_t slot = from % RING_SIZE;
+		size_t length = std::min(_tail - from, RING_SIZE - slot);
+		const char *hit = static_cast<const char *>(std::memchr(&_ring[slot], '\n', length));
+		if (hit)
+		{
+			position = from + static_cast<size_t>(hit - &_ring[slot]);
+			return true;
+		}
+		from += length;
+	}
+	return false;
+}
+
+// Exposes ring bytes [from, to) as one view: in place when they are
+// contiguous, through the line buffer when they wrap around the end.
+void LineReader::view(size_t from, size_t to, const char *&begin, const char *&end)
+{
+	size_t slot = from % RING_SIZE;
+	size_t length = to - from;
+	if (slot + length <= RING_SIZE)
+	{
+		begin = &_ring[slot];
+		end = begin + length;
+		return;
+	}
+	size_t first = RING_SIZE - slot;
+	std::memcpy(&_line[0], &_ring[slot], first);
+	std::memcpy(&_line[0] + first, &_ring[0], length - first);
+	begin = &_line[0];
+	end = begin + length;
+}
+
+// Reads into the free part of the ring. Returns false at end of input.
+bool LineReader::fill()
+{
+	while (true)
+	{
+		size_t slot = _tail % RING_SIZE;
+		size_t space = std::min(RING_SIZE - (_tail - _head), RING_SIZE - slot);
+		ssize_t n = read(_fd, &_ring[slot], space);
+		if (n > 0)
+		{
+			_tail += static_cast<size_t>(n);
+			return true;
+		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		_eof = true;
+		return false;
+	}
+}
+
+bool LineReader::nextStreamed(const char *&begin, const char *&end)
+{
+	while (true)
+	{
+		size_t newline;
+		if (findNewline(newline))
+		{
+			bool skipped = _skipping;
+			size_t from = _head;
+			_head = newline + 1;
+			_scanned = _head;
+			_skipping = false;
+			if (skipped)
+				continue;
+			view(from, newline, begin, end);
+			_hadNewline = true;
+			return true;
+		}
+		_scanned = _tail;
+		if (_skipping)
+			_head = _tail;
+		else if (_tail - _head == RING_SIZE)
+		{
+			// The line is longer than the ring: hand out what fits and drop
+			// the rest of it up to the next newline.
+			view(_head, _tail, begin, end);
+			_head = _tail;
+			_skipping = true;
+			_hadNewline = true;
+			return true;
+		}
+		if (_eof || !fill())
+		{
+			if (_head == _tail || _skipping)
+				return false;
+			view(_head, _tail, begin, end);
+			_head = _tail;
+			_hadNewline = false;
+			return true;
+		}
+	}
+}
+
+bool LineReader::hasLine() const
+{
+	if (_map)
+		return _offset < _mapSize;
+	size_t newline;
+	return findNewline(newline) || (_eof && _head != _tail);
+}
+
+bool LineReader::hadNewline() const
+{
+	return _hadNewline;
+}
+
+bool LineReader::isMapped() const
+{
+	return _map != NULL;
+}
+
+bool LineReader::remaining(const char *&begin, const char *&end)
+{
+	if (!_map)
+		return false;
+	begin = _map + _offset;
+	end = _map + _mapSize;
+	_offset = _mapSize;
+	return true;
+}
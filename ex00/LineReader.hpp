@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Hands out the lines of a file as [begin, end) views, without the trailing
+// '\n'. Regular files are memory-mapped so lines point straight into the page
+// cache. Pipes, FIFOs and stdin are streamed through a fixed-size ring
+// buffer, so memory use does not depend on the input size; a line that does
+// not fit in the ring is cut at RING_SIZE bytes and the rest of it skipped.
+// Views stay valid until the next call to next().
+class LineReader
+{
+public:
+	static const size_t RING_SIZE = 64 * 1024;
+
+	LineReader();
+	~LineReader();
+
+	bool open(const std::string &filename);
+	// Streams from an already open descriptor, which is not closed afterwards.
+	void openFd(int fd);
+	void close();
+
+	bool next(const char *&begin, const char *&end);
+	// Whether next() can return a line without waiting for more input.
+	bool hasLine() const;
+	// Whether the line last returned by next() was terminated by '\n'.
+	bool hadNewline() const;
+
+	bool isMapped() const;
+	// Hands out everything not yet returned by next() as one view and moves
+	// the reader to the end. Only available for memory-mapped files.
+	bool remaining(const char *&begin, const char *&end);
+
+private:
+	LineReader(const LineReader &other);
+	LineReader &operator=(const LineReader &other);
+
+	bool nextMapped(const char *&begin, const char *&end);
+	bool nextStreamed(const char *&begin, const char *&end);
+	bool findNewline(size_t &position) const;
+	void view(size_t from, size_t to, const char *&begin, const char *&end);
+	bool fill();
+
+	int _fd;
+	bool _ownsFd;
+	const char *_map;
+	size_t _mapSize;
+	size_t _offset;
+
+	// Ring positions are running byte counts; the slot is position % RING_SIZE.
+	std::vector<char> _ring;
+	std::vector<char> _line;
+	size_t _head;
+	size_t _tail;
+	size_t _scanned;
+	bool _skipping;
+	bool _eof;
+
+	bool _hadNewline;
+};
@@ -0,0 +1,63 @@
+#include "LookupCache.hpp"
+
+const size_t LookupCache::SLOTS;
+
+LookupCache::LookupCache() : _version(0), _hits(0), _misses(0)
+{
+	reset(0);
+}
+
+void LookupCache::reset(unsigned long version)
+{
+	for (size_t i = 0; i < SLOTS; ++i)
+	{
+		_slots[i].day = 0;
+		_slots[i].index = -1;
+	}
+	_version = version;
+}
+
+// The misses are collected in input order and resolved with one findBatch()
+// call, so a sorted ledger still gets the merge walk for them.
+void LookupCache::find(const RateTable &table, const int *days, size_t count, long *indices)
+{
+	if (table.version() != _version)
+		reset(table.version());
+	_missDays.clear();
+	_missPositions.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Slot &slot = _slots[static_cast<unsigned int>(days[i]) & (SLOTS - 1)];
+		if (slot.day == days[i] && slot.index >= 0)
+			indices[i] = slot.index;
+		else
+		{
+			_missDays.push_back(days[i]);
+			_missPositions.push_back(i);
+		}
+	}
+	_misses += _missDays.size();
+	_hits += count - _missDays.size();
+	if (_missDays.empty())
+		return;
+
+	_missIndices.resize(_missDays.size());
+	table.findBatch(&_missDays[0], _missDays.size(), &_missIndices[0]);
+	for (size_t i = 0; i < _missDays.size(); ++i)
+	{
+		indices[_missPositions[i]] = _missIndices[i];
+		Slot &slot = _slots[static_cast<unsigned int>(_missDays[i]) & (SLOTS - 1)];
+		slot.day = _missDays[i];
+		slot.index = static_cast<int>(_missIndices[i]);
+	}
+}
+
+unsigned long LookupCache::hits() const
+{
+	return _hits;
+}
+
+unsigned long LookupCache::misses() const
+{
+	return _misses;
+}
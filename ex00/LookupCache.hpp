@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "RateTable.hpp"
+
+// Direct-mapped cache of RateTable::find() answers keyed by day ordinal.
+// Ledgers repeat the same dates over and over; a repeated date is answered
+// from its slot without searching the table. Nearby days map to distinct
+// slots, and the 8 KiB of slots stay in L1. Entries belong to one version of
+// one table and are dropped as soon as another is looked up. A cache is not
+// shared between threads; each worker keeps its own.
+class LookupCache
+{
+public:
+	static const size_t SLOTS = 1024;
+
+	LookupCache();
+
+	// Writes table.find(days[i]) to indices[i], searching only for the days
+	// missing from the cache.
+	void find(const RateTable &table, const int *days, size_t count, long *indices);
+	unsigned long hits() const;
+	unsigned long misses() const;
+
+private:
+	struct Slot
+	{
+		int day;
+		int index;	// -1 when empty
+	};
+
+	void reset(unsigned long version);
+
+	Slot _slots[SLOTS];
+	unsigned long _version;
+	unsigned long _hits;
+	unsigned long _misses;
+	std::vector<int> _missDays;
+	std::vector<size_t> _missPositions;
+	std::vector<long> _missIndices;
+};
@@ -0,0 +1,148 @@
+#include "OutputBuffer.hpp"
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+OutputBuffer::OutputBuffer()
+{
+}
+
+void OutputBuffer::write(Stream stream, const char *text, size_t length)
+{
+	if (length == 0)
+		return;
+	if (_runs.empty() || _runs.back().stream != stream)
+	{
+		Run run = { stream, 0 };
+		_runs.push_back(run);
+	}
+	_runs.back().length += length;
+	_data.insert(_data.end(), text, text + length);
+}
+
+void OutputBuffer::write(Stream stream, const char *text)
+{
+	write(stream, text, std::strlen(text));
+}
+
+// Produces the same text as printf("%g"), i.e. six significant digits with
+// trailing zeros removed, without going through printf for the values btc
+// prints all the time. Anything that would need exponent notation, and the
+// rare values that sit too close to a rounding tie to decide safely from a
+// scaled double, are left to snprintf.
+static size_t formatDouble(double value, char *out)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+	double magnitude = value < 0 ? -value : value;
+	if (value == 0)
+	{
+		if (std::signbit(value))
+		{
+			std::memcpy(out, "-0", 2);
+			return 2;
+		}
+		out[0] = '0';
+		return 1;
+	}
+	if (!(magnitude >= 1e-4 && magnitude < 999999.5))
+		return static_cast<size_t>(std::snprintf(out, 32, "%g", value));
+
+	int exponent = 5;
+	while (exponent > -4 && magnitude < (exponent >= 0 ? powers[exponent] : 1 / powers[-exponent]))
+		--exponent;
+	double scaled = magnitude * powers[5 - exponent];
+	double whole = std::floor(scaled);
+	double fraction = scaled - whole;
+	if (std::fabs(fraction - 0.5) < 1e-6)
+		return static_cast<size_t>(std::snprintf(out, 32, "%g", value));
+	long digits = static_cast<long>(whole) + (fraction > 0.5);
+	if (digits == 1000000)
+	{
+		digits = 100000;
+		++exponent;
+	}
+	if (digits < 100000 || digits > 999999 || exponent > 5)
+		return static_cast<size_t>(std::snprintf(out, 32, "%g", value));
+
+	char text[6];
+	for (int i = 5; i >= 0; --i, digits /= 10)
+		text[i] = static_cast<char>('0' + digits % 10);
+	int last = 5;
+	while (last > 0 && last > exponent && text[last] == '0')
+		--last;
+
+	size_t length = 0;
+	if (value < 0)
+		out[length++] = '-';
+	if (exponent < 0)
+	{
+		out[length++] = '0';
+		out[length++] = '.';
+		for (int i = -1; i > exponent; --i)
+			out[length++] = '0';
+		for (int i = 0; i <= last; ++i)
+			out[length++] = text[i];
+		return length;
+	}
+	for (int i = 0; i <= exponent; ++i)
+		out[length++] = text[i];
+	if (last > exponent)
+	{
+		out[length++] = '.';
+		for (int i = exponent + 1; i <= last; ++i)
+			out[length++] = text[i];
+	}
+	return length;
+}
+
+void OutputBuffer::writeDouble(Stream stream, double value)
+{
+	char buf[32];
+	write(stream, buf, formatDouble(value, buf));
+}
+
+void OutputBuffer::flushTo(BufferedWriter &out, BufferedWriter &err, bool strictOrder)
+{
+	size_t offset = 0;
+	for (size_t i = 0; i < _runs.size(); ++i)
+	{
+		BufferedWriter &writer = _runs[i].stream == OUT ? out : err;
+		if (strictOrder)
+			(_runs[i].stream == OUT ? err : out).flush();
+		writer.write(&_data[offset], _runs[i].length);
+		offset += _runs[i].length;
+	}
+	clear();
+}
+
+bool OutputBuffer::writeTo(int fd)
+{
+	const char *data = _data.empty() ? NULL : &_data[0];
+	size_t length = _data.size();
+	while (length > 0)
+	{
+		ssize_t n = ::write(fd, data, length);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		length -= static_cast<size_t>(n);
+	}
+	clear();
+	return true;
+}
+
+void OutputBuffer::clear()
+{
+	_data.clear();
+	_runs.clear();
+}
+
+bool OutputBuffer::empty() const
+{
+	return _runs.empty();
+}
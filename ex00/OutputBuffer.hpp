@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "BufferedWriter.hpp"
+
+// Collects text destined for stdout and stderr while remembering the order
+// in which the two were written, so output produced off the main thread can
+// later be replayed with the same interleaving as direct writes.
+class OutputBuffer
+{
+public:
+	enum Stream
+	{
+		OUT,
+		ERR
+	};
+
+	OutputBuffer();
+
+	void write(Stream stream, const char *text, size_t length);
+	void write(Stream stream, const char *text);
+	// Formats like operator<<(double) with the default stream flags.
+	void writeDouble(Stream stream, double value);
+
+	// Hands the runs to the writers in order. With strictOrder, a writer is
+	// flushed before output switches to the other one, so the descriptors
+	// see the lines in their original order.
+	void flushTo(BufferedWriter &out, BufferedWriter &err, bool strictOrder);
+	// Writes both streams, in order, to one descriptor. False on write errors.
+	bool writeTo(int fd);
+	void clear();
+	bool empty() const;
+
+private:
+	struct Run
+	{
+		Stream stream;
+		size_t length;
+	};
+
+	std::vector<char> _data;
+	std::vector<Run> _runs;
+};
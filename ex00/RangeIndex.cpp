@@ -0,0 +1,122 @@
+#include "RangeIndex.hpp"
+
+#include <algorithm>
+
+RangeIndex::RangeIndex()
+{
+}
+
+void RangeIndex::build(const double *rates, size_t count)
+{
+	_prefix.clear();
+	_prefix.push_back(0);
+	for (size_t i = 0; i < count; ++i)
+		_prefix.push_back(_prefix.back() + rates[i]);
+
+	_min.assign(1, SharedColumn<double>());
+	_max.assign(1, SharedColumn<double>());
+	for (size_t i = 0; i < count; ++i)
+	{
+		_min[0].push_back(rates[i]);
+		_max[0].push_back(rates[i]);
+	}
+	for (size_t width = 2; width <= count; width *= 2)
+	{
+		size_t level = _min.size();
+		size_t half = width / 2;
+		_min.push_back(SharedColumn<double>());
+		_max.push_back(SharedColumn<double>());
+		for (size_t i = 0; i + width <= count; ++i)
+		{
+			_min[level].push_back(std::min(_min[level - 1][i], _min[level - 1][i + half]));
+			_max[level].push_back(std::max(_max[level - 1][i], _max[level - 1][i + half]));
+		}
+	}
+}
+
+// A new last row ends one run at every level: the run of width 2^k that
+// starts 2^k - 1 rows earlier, combined from two runs of the level below.
+void RangeIndex::push(double rate)
+{
+	if (_min.empty())
+	{
+		build(&rate, 1);
+		return;
+	}
+	_prefix.push_back(_prefix.back() + rate);
+	_min[0].push_back(rate);
+	_max[0].push_back(rate);
+	size_t count = _min[0].size();
+	for (size_t level = 1, width = 2; width <= count; ++level, width *= 2)
+	{
+		if (level == _min.size())
+		{
+			_min.push_back(SharedColumn<double>());
+			_max.push_back(SharedColumn<double>());
+		}
+		size_t start = count - width;
+		_min[level].push_back(std::min(_min[level - 1][start], _min[level - 1][start + width / 2]));
+		_max[level].push_back(std::max(_max[level - 1][start], _max[level - 1][start + width / 2]));
+	}
+}
+
+void RangeIndex::pop()
+{
+	_prefix.pop_back();
+	for (size_t level = 0; level < _min.size(); ++level)
+	{
+		_min[level].pop_back();
+		_max[level].pop_back();
+	}
+	while (!_min.empty() && _min.back().empty())
+	{
+		_min.pop_back();
+		_max.pop_back();
+	}
+}
+
+static size_t levelFor(size_t length)
+{
+	return static_cast<size_t>(63 - __builtin_clzll(static_cast<unsigned long long>(length)));
+}
+
+double RangeIndex::min(size_t begin, size_t end) const
+{
+	size_t level = levelFor(end - begin);
+	const SharedColumn<double> &row = _min[level];
+	return std::min(row[begin], row[end - (static_cast<size_t>(1) << level)]);
+}
+
+double RangeIndex::max(size_t begin, size_t end) const
+{
+	size_t level = levelFor(end - begin);
+	const SharedColumn<double> &row = _max[level];
+	return std::max(row[begin], row[end - (static_cast<size_t>(1) << level)]);
+}
+
+double RangeIndex::average(size_t begin, size_t end) const
+{
+	return static_cast<double>((_prefix[end] - _prefix[begin]) / static_cast<long double>(end - begin));
+}
+
+double RangeIndex::aggregate(Aggregate aggregate, size_t begin, size_t end) const
+{
+	switch (aggregate)
+	{
+		case MIN:
+			return min(begin, end);
+		case MAX:
+			return max(begin, end);
+		case AVG:
+			break;
+	}
+	return average(begin, end);
+}
+
+size_t RangeIndex::bytes() const
+{
+	size_t total = _prefix.size() * sizeof(long double);
+	for (size_t level = 0; level < _min.size(); ++level)
+		total += (_min[level].size() + _max[level].size()) * sizeof(double);
+	return total;
+}
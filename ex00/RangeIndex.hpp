@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// A column of values stored in fixed-size chunks. Only the last chunk ever
+// changes, so a copy shares every chunk with the original and push_back()
+// or pop_back() on either clones at most that last chunk first. Copying a
+// column of n values costs n / CHUNK pointers instead of n values.
+template <class T>
+class SharedColumn
+{
+public:
+	enum { SHIFT = 12, CHUNK = 1 << SHIFT };
+
+	SharedColumn() : _size(0) {}
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+	const T &operator[](size_t i) const { return (*_chunks[i >> SHIFT])[i & (CHUNK - 1)]; }
+	const T &back() const { return (*this)[_size - 1]; }
+
+	void clear()
+	{
+		_chunks.clear();
+		_size = 0;
+	}
+
+	void push_back(const T &value)
+	{
+		if (_size % CHUNK == 0)
+		{
+			_chunks.push_back(std::make_shared<std::vector<T> >());
+			_chunks.back()->reserve(CHUNK);
+		}
+		else
+			ownLast();
+		_chunks.back()->push_back(value);
+		++_size;
+	}
+
+	void pop_back()
+	{
+		ownLast();
+		_chunks.back()->pop_back();
+		if (_chunks.back()->empty())
+			_chunks.pop_back();
+		--_size;
+	}
+
+private:
+	// Copies of a RangeIndex are only made and changed by one thread at a
+	// time, so the use count tells whether the last chunk is shared.
+	void ownLast()
+	{
+		if (_chunks.back().use_count() > 1)
+			_chunks.back() = std::make_shared<std::vector<T> >(*_chunks.back());
+	}
+
+	std::vector<std::shared_ptr<std::vector<T> > > _chunks;
+	size_t _size;
+};
+
+// Answers aggregates over any run of consecutive rows of one rate column in
+// constant time. Averages come from prefix sums; minimum and maximum from a
+// sparse table holding, for every power of two 2^k, the extreme of each run
+// of 2^k rows, so any run is covered by two overlapping entries.
+//
+// Rows only ever change at the end, so every array is a SharedColumn: a copy
+// of an index shares all but the last chunk of each array with the original,
+// and appending to the copy leaves the original untouched.
+class RangeIndex
+{
+public:
+	enum Aggregate
+	{
+		MIN,
+		MAX,
+		AVG
+	};
+
+	RangeIndex();
+
+	void build(const double *rates, size_t count);
+	// Adds or removes the last row, in O(log n).
+	void push(double rate);
+	void pop();
+	// Aggregate of rows [begin, end), which must not be empty.
+	double aggregate(Aggregate aggregate, size_t begin, size_t end) const;
+	double min(size_t begin, size_t end) const;
+	double max(size_t begin, size_t end) const;
+	double average(size_t begin, size_t end) const;
+	size_t bytes() const;
+
+private:
+	// Sums are accumulated in extended precision so long ranges do not
+	// lose the small rates next to the large ones.
+	SharedColumn<long double> _prefix;
+	std::vector<SharedColumn<double> > _min;
+	std::vector<SharedColumn<double> > _max;
+};
@@ -0,0 +1,244 @@
+#include "RateServer.hpp"
+
+#include <csignal>
+#include <cerrno>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void handleStop(int)
+{
+	g_stop = 1;
+}
+
+static bool sameFile(const struct stat &a, const struct stat &b)
+{
+	return a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec
+		&& a.st_mtim.tv_nsec == b.st_mtim.tv_nsec && a.st_ino == b.st_ino;
+}
+
+static bool writeAll(int fd, const char *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t n = write(fd, data, length);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		length -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+static sockaddr_un socketAddress(const std::string &path)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.length() >= sizeof(address.sun_path))
+		throw std::runtime_error("Error: socket path too long.");
+	std::memcpy(address.sun_path, path.c_str(), path.length() + 1);
+	return address;
+}
+
+RateServer::RateServer(const std::string &socketPath, const std::string &database)
+	: _socketPath(socketPath), _database(database), _listener(-1)
+{
+	std::memset(&_loadedStat, 0, sizeof(_loadedStat));
+}
+
+RateServer::~RateServer()
+{
+	if (_listener >= 0)
+	{
+		close(_listener);
+		unlink(_socketPath.c_str());
+	}
+}
+
+// Builds a fresh exchange from the database and publishes it. A file that
+// yields no rates (for instance one caught halfway through being rewritten)
+// leaves the current table in place. The file is only recorded as loaded
+// once its table is published, so the watcher retries it until it does.
+bool RateServer::reload()
+{
+	struct stat fileStat;
+	if (stat(_database.c_str(), &fileStat) != 0)
+		return false;
+	std::shared_ptr<BitcoinExchange> exchange(new BitcoinExchange());
+	exchange->loadRates(_database);
+	if (exchange->rateCount() == 0)
+		return false;
+	std::shared_ptr<const BitcoinExchange> published(exchange);
+	std::atomic_store(&_exchange, published);
+	_loadedStat = fileStat;
+	return true;
+}
+
+void RateServer::watch()
+{
+	while (!g_stop)
+	{
+		usleep(500 * 1000);
+		struct stat fileStat;
+		if (stat(_database.c_str(), &fileStat) != 0 || sameFile(fileStat, _loadedStat))
+			continue;
+		// Rows appended to the file are added to a copy of the current
+		// table; anything else reloads it from scratch.
+		std::shared_ptr<BitcoinExchange> exchange(new BitcoinExchange(*std::atomic_load(&_exchange)));
+		long rows;
+		try
+		{
+			rows = exchange->appendRates();
+		}
+		catch (std::exception &e)
+		{
+			// A file rotated or removed under us: try a full reload instead.
+			rows = -1;
+		}
+		if (rows >= 0)
+		{
+			_loadedStat = fileStat;
+			std::shared_ptr<const BitcoinExchange> published(exchange);
+			std::atomic_store(&_exchange, published);
+			std::cerr << "btc: appended " << rows << " rates from " << _database << std::endl;
+		}
+		else
+		{
+			// A file that vanishes or turns bad mid-reload must not take the
+			// server down; the current table stays until the next change.
+			try
+			{
+				if (reload())
+					std::cerr << "btc: reloaded " << _database << " (" << std::atomic_load(&_exchange)->rateCount() << " rates)" << std::endl;
+			}
+			catch (std::exception &e)
+			{
+				std::cerr << "btc: keeping the current rates: " << e.what() << std::endl;
+			}
+		}
+	}
+}
+
+// Queries are priced in batches: whatever complete lines the client has
+// already sent are answered together, and the answers go out as soon as no
+// further line is waiting, so interactive clients get one reply per line.
+void RateServer::serve(int client)
+{
+	LineReader reader;
+	reader.openFd(client);
+	LineBatch batch;
+	OutputBuffer out;
+	int maxYear = calendar::currentYear();
+	const char *begin;
+	const char *end;
+	while (reader.next(begin, end))
+	{
+		batch.add(begin, end, maxYear);
+		if (batch.full() || !reader.hasLine())
+		{
+			std::shared_ptr<const BitcoinExchange> exchange = std::atomic_load(&_exchange);
+			exchange->processBatch(batch, out);
+			if (!out.writeTo(client))
+				break;
+		}
+	}
+	std::lock_guard<std::mutex> lock(_clientsLock);
+	_clients.erase(client);
+	close(client);
+	_clientsDone.notify_all();
+}
+
+// Unblocks every client thread still reading or writing and waits for all
+// of them to finish, so none outlives the server.
+void RateServer::drain()
+{
+	std::unique_lock<std::mutex> lock(_clientsLock);
+	for (std::set<int>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+		shutdown(*it, SHUT_RDWR);
+	while (!_clients.empty())
+		_clientsDone.wait(lock);
+}
+
+void RateServer::run()
+{
+	if (!reload())
+		throw std::runtime_error("Error: could not load the rate database.");
+
+	sockaddr_un address = socketAddress(_socketPath);
+	_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (_listener < 0)
+		throw std::runtime_error("Error: could not create socket.");
+	unlink(_socketPath.c_str());
+	if (bind(_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(_listener, 128) != 0)
+		throw std::runtime_error("Error: could not listen on " + _socketPath + ".");
+
+	std::signal(SIGINT, handleStop);
+	std::signal(SIGTERM, handleStop);
+	std::signal(SIGPIPE, SIG_IGN);
+	std::thread watcher(&RateServer::watch, this);
+	std::cerr << "btc: serving " << _database << " on " << _socketPath << std::endl;
+	while (!g_stop)
+	{
+		pollfd pfd = { _listener, POLLIN, 0 };
+		if (poll(&pfd, 1, 200) <= 0)
+			continue;
+		int client = accept(_listener, NULL, NULL);
+		if (client < 0)
+			continue;
+		std::lock_guard<std::mutex> lock(_clientsLock);
+		_clients.insert(client);
+		std::thread(&RateServer::serve, this, client).detach();
+	}
+	drain();
+	watcher.join();
+}
+
+int runClient(const std::string &socketPath, const std::string &input)
+{
+	int in = STDIN_FILENO;
+	if (input != "-")
+	{
+		in = open(input.c_str(), O_RDONLY);
+		if (in < 0)
+		{
+			std::cerr << "Error: could not open file." << std::endl;
+			return 1;
+		}
+	}
+	sockaddr_un address = socketAddress(socketPath);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+	{
+		std::cerr << "Error: could not connect to " << socketPath << "." << std::endl;
+		return 1;
+	}
+	std::signal(SIGPIPE, SIG_IGN);
+
+	// Requests are sent from a second thread so a large input cannot
+	// deadlock against the server's replies.
+	std::thread sender([fd, in]()
+	{
+		char buf[64 * 1024];
+		ssize_t n;
+		while ((n = read(in, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR))
+			if (n > 0 && !writeAll(fd, buf, static_cast<size_t>(n)))
+				break;
+		shutdown(fd, SHUT_WR);
+	});
+	char buf[64 * 1024];
+	ssize_t n;
+	while ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR))
+		if (n > 0 && !writeAll(STDOUT_FILENO, buf, static_cast<size_t>(n)))
+			break;
+	sender.join();
+	close(fd);
+	if (in != STDIN_FILENO)
+		close(in);
+	return 0;
+}
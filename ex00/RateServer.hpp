@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <sys/stat.h>
+#include "BitcoinExchange.hpp"
+
+// Long-running query server. Loads the rate table once and answers
+// "date | value" lines over a Unix domain socket with exactly the lines btc
+// would print for them, one response line per query line.
+//
+// The table lives in an immutable BitcoinExchange published through a
+// shared_ptr. When the CSV changes on disk a new one is built on the side,
+// from a copy of the current one plus the appended rows when the file only
+// grew and from scratch otherwise, and swapped in atomically; queries already
+// running keep the instance they started with, which is released once the
+// last of them finishes.
+//
+// Each client is served on its own thread. On shutdown the open connections
+// are shut down and run() waits for their threads before returning.
+class RateServer
+{
+public:
+	RateServer(const std::string &socketPath, const std::string &database);
+	~RateServer();
+
+	void run();
+
+private:
+	RateServer(const RateServer &other);
+	RateServer &operator=(const RateServer &other);
+
+	bool reload();
+	void watch();
+	void serve(int client);
+	void drain();
+
+	std::string _socketPath;
+	std::string _database;
+	std::shared_ptr<const BitcoinExchange> _exchange;
+	struct stat _loadedStat;
+	int _listener;
+	std::mutex _clientsLock;
+	std::condition_variable _clientsDone;
+	std::set<int> _clients;
+};
+
+// Sends input ("-" for stdin) to a running server and prints its answers.
+int runClient(const std::string &socketPath, const std::string &input);
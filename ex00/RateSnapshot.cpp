@@ -0,0 +1,221 @@
+#include "RateSnapshot.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const char SNAPSHOT_MAGIC[8] = { 'B', 'T', 'C', 'R', 'A', 'T', 'E', 'S' };
+static const uint32_t SNAPSHOT_VERSION = 2;
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+namespace
+{
+	struct Unmapper
+	{
+		size_t size;
+		void operator()(const void *map) const { munmap(const_cast<void *>(map), size); }
+	};
+
+	class MappedSnapshot
+	{
+	public:
+		MappedSnapshot() : map(NULL), size(0) {}
+
+		bool open(const std::string &path)
+		{
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat fileStat;
+			if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)
+				|| static_cast<size_t>(fileStat.st_size) < sizeof(SnapshotHeader))
+			{
+				::close(fd);
+				return false;
+			}
+			size = static_cast<size_t>(fileStat.st_size);
+			void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (mapped == MAP_FAILED)
+				return false;
+			map = mapped;
+			return true;
+		}
+
+		const SnapshotHeader &header() const { return *static_cast<const SnapshotHeader *>(map); }
+		const char *names() const { return static_cast<const char *>(map) + sizeof(SnapshotHeader); }
+		const int *days() const { return reinterpret_cast<const int *>(names() + header().namesBytes); }
+		const double *rates() const { return reinterpret_cast<const double *>(reinterpret_cast<const char *>(days()) + daysBytes(header().count)); }
+
+		// Checks everything that can be checked without touching the arrays,
+		// and splits the asset names.
+		bool wellFormed(std::vector<std::string> &assets) const
+		{
+			const SnapshotHeader &h = header();
+			size_t available = size - sizeof(SnapshotHeader);
+			if (std::memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+				|| h.version != SNAPSHOT_VERSION
+				|| h.byteOrder != SNAPSHOT_BYTE_ORDER
+				|| h.assets == 0 || h.assets > available / sizeof(double)
+				|| h.namesBytes % 8 != 0 || h.namesBytes > available
+				|| h.count > available / (sizeof(int) + h.assets * sizeof(double))
+				|| size != fileSize(h.count, h.assets, h.namesBytes))
+				return false;
+			assets.clear();
+			const char *p = names();
+			const char *end = p + h.namesBytes;
+			while (assets.size() < h.assets)
+			{
+				const char *nul = static_cast<const char *>(std::memchr(p, '\0', end - p));
+				if (nul == NULL)
+					return false;
+				assets.push_back(std::string(p, nul));
+				p = nul + 1;
+			}
+			return true;
+		}
+
+		static size_t daysBytes(uint64_t count) { return (static_cast<size_t>(count) * sizeof(int) + 7) & ~static_cast<size_t>(7); }
+		static size_t fileSize(uint64_t count, uint64_t assets, uint64_t namesBytes)
+		{
+			return sizeof(SnapshotHeader) + static_cast<size_t>(namesBytes) + daysBytes(count)
+				+ static_cast<size_t>(assets * count) * sizeof(double);
+		}
+
+		const void *map;
+		size_t size;
+	};
+}
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t length)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static uint64_t checksum(const char *names, size_t namesBytes, const int *days, const double *rates, size_t count, size_t assets)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hash = fnv1a(hash, names, namesBytes);
+	hash = fnv1a(hash, days, count * sizeof(int));
+	return fnv1a(hash, rates, assets * count * sizeof(double));
+}
+
+static bool daysSorted(const int *days, size_t count)
+{
+	for (size_t i = 1; i < count; ++i)
+		if (days[i - 1] >= days[i])
+			return false;
+	return true;
+}
+
+static bool checksumMatches(const MappedSnapshot &snapshot, size_t assets)
+{
+	return checksum(snapshot.names(), static_cast<size_t>(snapshot.header().namesBytes), snapshot.days(), snapshot.rates(),
+		static_cast<size_t>(snapshot.header().count), assets) == snapshot.header().checksum;
+}
+
+static bool matchesSource(const SnapshotHeader &header, const struct stat &source)
+{
+	return header.sourceSize == static_cast<uint64_t>(source.st_size)
+		&& header.sourceMtimeSec == static_cast<int64_t>(source.st_mtim.tv_sec)
+		&& header.sourceMtimeNsec == static_cast<int64_t>(source.st_mtim.tv_nsec);
+}
+
+std::string snapshotPath(const std::string &csvFilename)
+{
+	return csvFilename + ".snap";
+}
+
+void writeSnapshot(const RateTable &table, const std::string &path, const struct stat &source)
+{
+	std::vector<char> names;
+	for (size_t a = 0; a < table.assetCount(); ++a)
+		names.insert(names.end(), table.assetName(a).c_str(), table.assetName(a).c_str() + table.assetName(a).length() + 1);
+	names.resize((names.size() + 7) & ~static_cast<size_t>(7));
+
+	SnapshotHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.version = SNAPSHOT_VERSION;
+	header.byteOrder = SNAPSHOT_BYTE_ORDER;
+	header.count = table.size();
+	header.assets = table.assetCount();
+	header.namesBytes = names.size();
+	header.sourceSize = static_cast<uint64_t>(source.st_size);
+	header.sourceMtimeSec = static_cast<int64_t>(source.st_mtim.tv_sec);
+	header.sourceMtimeNsec = static_cast<int64_t>(source.st_mtim.tv_nsec);
+	uint64_t hash = 14695981039346656037ULL;
+	hash = fnv1a(hash, &names[0], names.size());
+	hash = fnv1a(hash, table.days(), table.size() * sizeof(int));
+	for (size_t a = 0; a < table.assetCount(); ++a)
+		hash = fnv1a(hash, table.rates(a), table.size() * sizeof(double));
+	header.checksum = hash;
+
+	// Written under a temporary name and renamed so a concurrent reader
+	// never maps a half-written snapshot.
+	std::string tmpPath = path + ".tmp";
+	std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("Error: could not create snapshot file.");
+	static const char padding[8] = {0};
+	size_t daysBytes = table.size() * sizeof(int);
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(&names[0], names.size());
+	if (table.size() > 0)
+	{
+		file.write(reinterpret_cast<const char *>(table.days()), daysBytes);
+		file.write(padding, MappedSnapshot::daysBytes(table.size()) - daysBytes);
+		for (size_t a = 0; a < table.assetCount(); ++a)
+			file.write(reinterpret_cast<const char *>(table.rates(a)), table.size() * sizeof(double));
+	}
+	file.close();
+	if (!file || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tmpPath.c_str());
+		throw std::runtime_error("Error: could not write snapshot file.");
+	}
+}
+
+bool loadSnapshot(const std::string &path, const struct stat &source, RateTable &table)
+{
+	MappedSnapshot snapshot;
+	if (!snapshot.open(path))
+		return false;
+	std::shared_ptr<const void> storage(snapshot.map, Unmapper{ snapshot.size });
+	std::vector<std::string> assets;
+	if (!snapshot.wellFormed(assets) || !matchesSource(snapshot.header(), source))
+		return false;
+	// A damaged snapshot would give wrong prices without any error, so it is
+	// checked in full; that is one pass over the file, still far cheaper
+	// than parsing the CSV it replaces.
+	if (!daysSorted(snapshot.days(), static_cast<size_t>(snapshot.header().count)) || !checksumMatches(snapshot, assets.size()))
+		return false;
+	table.adopt(storage, snapshot.days(), snapshot.rates(), static_cast<size_t>(snapshot.header().count), assets);
+	return true;
+}
+
+void verifySnapshot(const std::string &path)
+{
+	MappedSnapshot snapshot;
+	if (!snapshot.open(path))
+		throw std::runtime_error("Error: could not open snapshot file.");
+	std::shared_ptr<const void> storage(snapshot.map, Unmapper{ snapshot.size });
+	std::vector<std::string> assets;
+	if (!snapshot.wellFormed(assets))
+		throw std::runtime_error("Error: not a valid snapshot file.");
+	if (!daysSorted(snapshot.days(), static_cast<size_t>(snapshot.header().count)))
+		throw std::runtime_error("Error: snapshot days are not sorted.");
+	if (!checksumMatches(snapshot, assets.size()))
+		throw std::runtime_error("Error: snapshot checksum mismatch.");
+}
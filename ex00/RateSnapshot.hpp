@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "RateTable.hpp"
+
+// Binary snapshot of a finalized RateTable, written next to the CSV it was
+// built from. Layout (native byte order, which byteOrder records):
+//
+//   SnapshotHeader
+//   char    names[namesBytes]        (assets NUL-terminated names, padded to 8)
+//   int32_t days[count]              (padded to a multiple of 8 bytes)
+//   double  rates[assets][count]     (one column per asset)
+//
+// The arrays are used in place through mmap, so loading does not depend on
+// the number of rows. The checksum is FNV-1a over the names and the arrays;
+// it is checked on every load, together with the order of the days.
+struct SnapshotHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t count;
+	uint64_t assets;
+	uint64_t namesBytes;
+	uint64_t sourceSize;
+	int64_t sourceMtimeSec;
+	int64_t sourceMtimeNsec;
+	uint64_t checksum;
+};
+
+std::string snapshotPath(const std::string &csvFilename);
+
+// Writes table to path, recording source as the CSV it reflects.
+void writeSnapshot(const RateTable &table, const std::string &path, const struct stat &source);
+
+// Maps path into table if it is an intact snapshot of source as it is now.
+// Returns false, leaving table untouched, when it is missing, stale or
+// damaged, so that the caller falls back to the CSV.
+bool loadSnapshot(const std::string &path, const struct stat &source, RateTable &table);
+
+// Full validation, including the checksum and ordering of the days. Throws
+// std::runtime_error describing the first problem found.
+void verifySnapshot(const std::string &path);
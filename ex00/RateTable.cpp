@@ -0,0 +1,376 @@
+#include "RateTable.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstring>
+#include <atomic>
+
+static std::atomic<unsigned long> g_nextVersion(1);
+
+RateTable::RateTable() : _days(NULL), _count(0), _version(0)
+{
+	clear();
+}
+
+RateTable::RateTable(const RateTable &other) : _days(NULL), _count(0), _version(0)
+{
+	*this = other;
+}
+
+RateTable &RateTable::operator=(const RateTable &other)
+{
+	if (this != &other)
+	{
+		_assets = other._assets;
+		_ownedDays = other._ownedDays;
+		_ownedRates = other._ownedRates;
+		_storage = other._storage;
+		if (_storage)
+		{
+			_days = other._days;
+			_rates = other._rates;
+			_count = other._count;
+		}
+		else
+			attachOwned();
+		_version = other._version;
+	}
+	return *this;
+}
+
+RateTable::~RateTable()
+{
+}
+
+void RateTable::attachOwned()
+{
+	_days = _ownedDays.empty() ? NULL : &_ownedDays[0];
+	_rates.resize(_ownedRates.size());
+	for (size_t a = 0; a < _ownedRates.size(); ++a)
+		_rates[a] = _ownedRates[a].empty() ? NULL : &_ownedRates[a][0];
+	_count = _ownedDays.size();
+	_version = g_nextVersion++;
+}
+
+// Copies borrowed arrays into owned storage so the table can be modified.
+void RateTable::materialize()
+{
+	if (!_storage)
+		return;
+	_ownedDays.assign(_days, _days + _count);
+	_ownedRates.resize(_rates.size());
+	for (size_t a = 0; a < _rates.size(); ++a)
+		_ownedRates[a].assign(_rates[a], _rates[a] + _count);
+	_storage.reset();
+	attachOwned();
+}
+
+void RateTable::clear()
+{
+	setAssets(std::vector<std::string>(1));
+}
+
+void RateTable::setAssets(const std::vector<std::string> &names)
+{
+	_storage.reset();
+	_assets = names;
+	_ownedDays.clear();
+	_ownedRates.assign(names.size(), std::vector<double>());
+	attachOwned();
+}
+
+void RateTable::renameAsset(size_t asset, const std::string &name)
+{
+	_assets[asset] = name;
+}
+
+void RateTable::insert(int day, double rate)
+{
+	insert(day, &rate);
+}
+
+void RateTable::insert(int day, const double *rates)
+{
+	materialize();
+	_ownedDays.push_back(day);
+	for (size_t a = 0; a < _ownedRates.size(); ++a)
+		_ownedRates[a].push_back(rates[a]);
+	attachOwned();
+}
+
+void RateTable::appendRow(int day, size_t firstAsset, const double *rates, size_t count)
+{
+	materialize();
+	if (_ownedDays.empty() || day > _ownedDays.back())
+	{
+		for (size_t a = 0; a < _ownedRates.size(); ++a)
+			_ownedRates[a].push_back(_ownedDays.empty() ? std::numeric_limits<double>::quiet_NaN() : _ownedRates[a].back());
+		_ownedDays.push_back(day);
+		attachOwned();
+	}
+	for (size_t a = 0; a < count; ++a)
+		_ownedRates[firstAsset + a].back() = rates[a];
+	_version = g_nextVersion++;
+}
+
+void RateTable::adopt(const std::shared_ptr<const void> &storage, const int *days, const double *rates, size_t count,
+	const std::vector<std::string> &assets)
+{
+	_ownedDays.clear();
+	_ownedRates.clear();
+	_storage = storage;
+	_assets = assets;
+	_days = days;
+	_rates.resize(assets.size());
+	for (size_t a = 0; a < assets.size(); ++a)
+		_rates[a] = rates + a * count;
+	_count = count;
+	_version = g_nextVersion++;
+}
+
+namespace
+{
+	struct DayLess
+	{
+		const std::vector<int> *days;
+		bool operator()(size_t a, size_t b) const { return (*days)[a] < (*days)[b]; }
+	};
+}
+
+// Sorts the rows by day. When a day appears more than once the row inserted
+// last wins, which is what assigning into a map keyed by date used to do.
+void RateTable::finalize()
+{
+	bool sorted = true;
+	for (size_t i = 1; i < _count && sorted; ++i)
+		sorted = _days[i - 1] < _days[i];
+	if (sorted)
+		return;
+
+	materialize();
+	std::vector<size_t> order(_ownedDays.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	DayLess less = { &_ownedDays };
+	std::stable_sort(order.begin(), order.end(), less);
+
+	std::vector<int> days;
+	std::vector<size_t> rows;
+	days.reserve(order.size());
+	rows.reserve(order.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		if (!days.empty() && days.back() == _ownedDays[order[i]])
+			rows.back() = order[i];
+		else
+		{
+			days.push_back(_ownedDays[order[i]]);
+			rows.push_back(order[i]);
+		}
+	}
+	for (size_t a = 0; a < _ownedRates.size(); ++a)
+	{
+		std::vector<double> rates(rows.size());
+		for (size_t i = 0; i < rows.size(); ++i)
+			rates[i] = _ownedRates[a][rows[i]];
+		_ownedRates[a].swap(rates);
+	}
+	_ownedDays.swap(days);
+	attachOwned();
+}
+
+void RateTable::merge(const RateTable &other)
+{
+	if (_count == 0 && _assets.size() == 1 && _assets[0].empty())
+	{
+		*this = other;
+		return;
+	}
+	std::vector<int> days;
+	days.reserve(_count + other._count);
+	std::set_union(_days, _days + _count, other._days, other._days + other._count, std::back_inserter(days));
+
+	std::vector<std::vector<double> > columns;
+	const RateTable *tables[2] = { this, &other };
+	std::vector<size_t> rows(days.size());
+	for (int t = 0; t < 2; ++t)
+	{
+		const RateTable &table = *tables[t];
+		size_t row = 0;
+		for (size_t i = 0; i < days.size(); ++i)
+		{
+			while (row + 1 < table._count && table._days[row + 1] <= days[i])
+				++row;
+			rows[i] = row;
+		}
+		for (size_t a = 0; a < table._rates.size(); ++a)
+		{
+			// An asset without any rows has nothing to carry forward.
+			columns.push_back(std::vector<double>(days.size(), std::numeric_limits<double>::quiet_NaN()));
+			for (size_t i = 0; i < days.size() && table._count > 0; ++i)
+				columns.back()[i] = table._rates[a][rows[i]];
+		}
+	}
+	_assets.insert(_assets.end(), other._assets.begin(), other._assets.end());
+	_storage.reset();
+	_ownedDays.swap(days);
+	_ownedRates.swap(columns);
+	attachOwned();
+}
+
+// Interpolation search: rate histories are close to evenly spaced in time,
+// so the first probe usually lands on the answer or its neighbour. Whatever
+// range is left after a few probes is finished with a branchless binary search.
+long RateTable::find(int day) const
+{
+	if (_count == 0)
+		return -1;
+	const int *days = _days;
+	size_t lo = 0;
+	size_t hi = _count - 1;
+	if (day <= days[lo])
+		return 0;
+	if (day >= days[hi])
+		return static_cast<long>(hi);
+
+	// invariant: days[lo] <= day < days[hi]
+	for (int probe = 0; probe < 3 && hi - lo > 8; ++probe)
+	{
+		unsigned long long span = static_cast<unsigned long long>(days[hi] - days[lo]);
+		unsigned long long offset = static_cast<unsigned long long>(day - days[lo]);
+		size_t mid = lo + static_cast<size_t>(offset * (hi - lo) / span);
+		if (days[mid] <= day)
+		{
+			if (days[mid + 1] > day)
+				return static_cast<long>(mid);
+			lo = mid + 1;
+		}
+		else
+		{
+			if (days[mid - 1] <= day)
+				return static_cast<long>(mid - 1);
+			hi = mid - 1;
+		}
+	}
+
+	const int *base = days + lo;
+	size_t len = hi - lo;
+	while (len > 1)
+	{
+		size_t half = len / 2;
+		base = (base[half] <= day) ? base + half : base;
+		len -= half;
+	}
+	return static_cast<long>(base - days);
+}
+
+// Queries that arrive in ascending order, as dates in a ledger or a sorted
+// portfolio usually do, are answered by walking forward from the previous
+// answer: a galloping probe brackets the next answer and a short binary
+// search finishes it, so a sorted batch costs one merge pass over the table.
+// Unordered batches gain nothing from the walk and use find() per query.
+void RateTable::findBatch(const int *days, size_t count, long *indices) const
+{
+	bool ascending = true;
+	for (size_t i = 1; i < count && ascending; ++i)
+		ascending = days[i - 1] <= days[i];
+	if (!ascending || _count == 0)
+	{
+		for (size_t i = 0; i < count; ++i)
+			indices[i] = find(days[i]);
+		return;
+	}
+
+	const size_t last = _count - 1;
+	size_t i = 0;
+	for (; i < count && days[i] <= _days[0]; ++i)
+		indices[i] = 0;
+	size_t pos = 0;
+	for (; i < count; ++i)
+	{
+		// invariant: _days[pos] <= days[i]
+		int day = days[i];
+		size_t step = 1;
+		size_t lo = pos;
+		while (lo + step <= last && _days[lo + step] <= day)
+		{
+			lo += step;
+			step *= 2;
+		}
+		const int *base = _days + lo;
+		size_t len = std::min(step, last - lo + 1);
+		while (len > 1)
+		{
+			size_t half = len / 2;
+			base = (base[half] <= day) ? base + half : base;
+			len -= half;
+		}
+		pos = static_cast<size_t>(base - _days);
+		indices[i] = static_cast<long>(pos);
+	}
+}
+
+void RateTable::rowsBetween(int firstDay, int lastDay, size_t &begin, size_t &end) const
+{
+	begin = static_cast<size_t>(std::lower_bound(_days, _days + _count, firstDay) - _days);
+	end = static_cast<size_t>(std::upper_bound(_days + begin, _days + _count, lastDay) - _days);
+}
+
+long RateTable::assetIndex(const char *name, size_t length) const
+{
+	for (size_t a = 0; a < _assets.size(); ++a)
+		if (_assets[a].length() == length && std::memcmp(_assets[a].data(), name, length) == 0)
+			return static_cast<long>(a);
+	return -1;
+}
+
+size_t RateTable::size() const
+{
+	return _count;
+}
+
+bool RateTable::empty() const
+{
+	return _count == 0;
+}
+
+int RateTable::dayAt(size_t i) const
+{
+	return _days[i];
+}
+
+size_t RateTable::assetCount() const
+{
+	return _assets.size();
+}
+
+const std::string &RateTable::assetName(size_t asset) const
+{
+	return _assets[asset];
+}
+
+double RateTable::rateAt(size_t i) const
+{
+	return _rates[0][i];
+}
+
+double RateTable::rateAt(size_t i, size_t asset) const
+{
+	return _rates[asset][i];
+}
+
+const int *RateTable::days() const
+{
+	return _days;
+}
+
+const double *RateTable::rates(size_t asset) const
+{
+	return _rates[asset];
+}
+
+unsigned long RateTable::version() const
+{
+	return _version;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Exchange rates stored column by column: one packed array of day ordinals
+// sorted ascending, shared by every asset, and one contiguous rate array per
+// asset indexed like the days. A lookup resolves the day once and the index
+// it finds is valid in every column, so adding assets costs one rate column
+// each and nothing at lookup time.
+// Rows are appended with insert() and become searchable after finalize().
+// A table can also borrow its arrays from external storage such as a mapped
+// snapshot file, which it keeps alive for as long as it refers to it.
+class RateTable
+{
+public:
+	RateTable();
+	RateTable(const RateTable &other);
+	RateTable &operator=(const RateTable &other);
+	~RateTable();
+
+	// Resets to an empty table with a single unnamed asset.
+	void clear();
+	// Replaces the assets of an empty table.
+	void setAssets(const std::vector<std::string> &names);
+	void renameAsset(size_t asset, const std::string &name);
+	// Appends a row to a single-asset table.
+	void insert(int day, double rate);
+	// Appends a row holding one rate per asset, in asset order.
+	void insert(int day, const double *rates);
+	void finalize();
+	// Adds the assets of other, a finalized table, as new columns. The day
+	// column becomes the union of both; an asset with no row on a day takes
+	// its rate from its closest earlier day, or its first day, as find()
+	// would have answered on its own table.
+	void merge(const RateTable &other);
+	// Sets the rates of assets [firstAsset, firstAsset + count) on day, which
+	// must not come before the last row. A later day becomes a new last row
+	// in which the other assets keep their latest rates.
+	void appendRow(int day, size_t firstAsset, const double *rates, size_t count);
+	// rates holds count rates for each asset, one asset after the other.
+	void adopt(const std::shared_ptr<const void> &storage, const int *days, const double *rates, size_t count,
+		const std::vector<std::string> &assets);
+
+	// Index of the closest entry on or before day. Days before the first
+	// entry resolve to the first entry; returns -1 when the table is empty.
+	long find(int day) const;
+	// Resolves count days at once, writing find(days[i]) to indices[i].
+	void findBatch(const int *days, size_t count, long *indices) const;
+	// Rows [begin, end) whose days fall between firstDay and lastDay inclusive.
+	void rowsBetween(int firstDay, int lastDay, size_t &begin, size_t &end) const;
+	// Column of the named asset, or -1 if there is none.
+	long assetIndex(const char *name, size_t length) const;
+
+	size_t size() const;
+	bool empty() const;
+	size_t assetCount() const;
+	const std::string &assetName(size_t asset) const;
+	int dayAt(size_t i) const;
+	double rateAt(size_t i) const;
+	double rateAt(size_t i, size_t asset) const;
+	const int *days() const;
+	const double *rates(size_t asset = 0) const;
+	// Changes whenever the contents change, and is never reused by another
+	// table, so results derived from one version can be recognised as stale.
+	unsigned long version() const;
+
+private:
+	void materialize();
+	void attachOwned();
+
+	std::vector<std::string> _assets;
+	std::vector<int> _ownedDays;
+	std::vector<std::vector<double> > _ownedRates;
+	std::shared_ptr<const void> _storage;
+	const int *_days;
+	std::vector<const double *> _rates;
+	size_t _count;
+	unsigned long _version;
+};
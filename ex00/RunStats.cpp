@@ -0,0 +1,42 @@
+#include "RunStats.hpp"
+
+#include <algorithm>
+
+const unsigned long RunStats::SAMPLE_EVERY;
+
+RunStats::RunStats() : batches(0), cacheHits(0), cacheMisses(0), loadSeconds(0), processSeconds(0)
+{
+	std::fill(outcomes, outcomes + OUTCOMES, 0);
+}
+
+void RunStats::merge(const RunStats &other)
+{
+	for (int i = 0; i < OUTCOMES; ++i)
+		outcomes[i] += other.outcomes[i];
+	batches += other.batches;
+	cacheHits += other.cacheHits;
+	cacheMisses += other.cacheMisses;
+	batchLookupSamples.insert(batchLookupSamples.end(), other.batchLookupSamples.begin(), other.batchLookupSamples.end());
+	loadSeconds += other.loadSeconds;
+	processSeconds += other.processSeconds;
+}
+
+unsigned long RunStats::lines() const
+{
+	unsigned long total = 0;
+	for (int i = 0; i < OUTCOMES; ++i)
+		total += outcomes[i];
+	return total;
+}
+
+// Nearest-rank percentile over the samples taken so far.
+double RunStats::batchLookupPercentile(double percentile) const
+{
+	if (batchLookupSamples.empty())
+		return 0;
+	std::vector<float> sorted(batchLookupSamples);
+	size_t rank = static_cast<size_t>(percentile / 100 * static_cast<double>(sorted.size()));
+	rank = std::min(rank, sorted.size() - 1);
+	std::nth_element(sorted.begin(), sorted.begin() + static_cast<long>(rank), sorted.end());
+	return sorted[rank];
+}
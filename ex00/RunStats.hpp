@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Counters and timings behind btc --stats. They are always collected: each
+// worker counts into the RunStats of its own LineBatch with plain
+// increments, and the instances are merged once the input is done.
+// Lookups are resolved a batch at a time, so there is no per-lookup time to
+// report: one batch in SAMPLE_EVERY is timed instead, and its time divided
+// by the days it looked up becomes one sample of the average lookup time.
+struct RunStats
+{
+	enum Outcome
+	{
+		PRICED,			// "date => value = result"
+		AGGREGATED,		// "from..to => avg = result"
+		BAD_INPUT,
+		NOT_POSITIVE,
+		TOO_LARGE,
+		NO_MATCH,
+		OUTCOMES
+	};
+
+	static const unsigned long SAMPLE_EVERY = 16;
+
+	RunStats();
+
+	void merge(const RunStats &other);
+	unsigned long lines() const;
+	// Percentile (0-100) of the sampled per-batch average lookup time, in
+	// nanoseconds per day looked up.
+	double batchLookupPercentile(double percentile) const;
+
+	unsigned long outcomes[OUTCOMES];
+	unsigned long batches;
+	unsigned long cacheHits;
+	unsigned long cacheMisses;
+	std::vector<float> batchLookupSamples;
+	double loadSeconds;
+	double processSeconds;
+};
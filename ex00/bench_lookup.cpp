@@ -0,0 +1,148 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "RateTable.hpp"
+#include "Date.hpp"
+#include "LookupCache.hpp"
+#include "BenchTimer.hpp"
+
+// Compares the packed RateTable lookup against the std::map<std::string,
+// double> path btc used before: findClosestDate() followed by a second
+// database[closestDate] access to fetch the rate.
+
+static std::string mapClosestDate(std::map<std::string, double> &database, const std::string &date)
+{
+	auto it = database.find(date);
+	if (it != database.end())
+		return it->first;
+	auto upper = database.upper_bound(date);
+	if (upper == database.begin())
+		return database.begin()->first;
+	return std::prev(upper)->first;
+}
+
+int main(int argc, char **argv)
+{
+	std::string filename = argc > 1 ? argv[1] : "data.csv";
+	size_t queries = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 2000000;
+
+	std::ifstream file(filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "Error: could not open " << filename << std::endl;
+		return 1;
+	}
+	std::map<std::string, double> database;
+	RateTable table;
+	std::string line;
+	std::getline(file, line);
+	while (std::getline(file, line))
+	{
+		std::istringstream iss(line);
+		std::string date;
+		double value = 0;
+		int day;
+		std::getline(iss, date, ',');
+		iss >> value;
+		database[date] = value;
+		if (parseDay(date, day))
+			table.insert(day, value);
+	}
+	table.finalize();
+	if (table.empty())
+	{
+		std::cerr << "Error: empty rate table" << std::endl;
+		return 1;
+	}
+
+	// Queries span the table plus a margin on both sides.
+	int first = table.dayAt(0) - 30;
+	int range = table.dayAt(table.size() - 1) + 30 - first;
+	std::vector<int> days(queries);
+	std::vector<std::string> dates(queries);
+	unsigned int seed = 42;
+	for (size_t i = 0; i < queries; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		days[i] = first + static_cast<int>((seed >> 8) % static_cast<unsigned int>(range));
+		dates[i] = dayToString(days[i]);
+	}
+
+	double mapSum = 0;
+	BenchTimer timer;
+	for (size_t i = 0; i < queries; ++i)
+		mapSum += database[mapClosestDate(database, dates[i])];
+	double mapTime = timer.seconds();
+
+	double tableSum = 0;
+	timer = BenchTimer();
+	for (size_t i = 0; i < queries; ++i)
+		tableSum += table.rateAt(table.find(days[i]));
+	double tableTime = timer.seconds();
+
+	std::vector<long> indices(queries);
+	timer = BenchTimer();
+	table.findBatch(&days[0], queries, &indices[0]);
+	double batchSum = 0;
+	for (size_t i = 0; i < queries; ++i)
+		batchSum += table.rateAt(indices[i]);
+	double batchTime = timer.seconds();
+	bool batchMatches = true;
+	for (size_t i = 0; i < queries; ++i)
+		batchMatches = batchMatches && indices[i] == table.find(days[i]);
+
+	std::sort(days.begin(), days.end());
+	timer = BenchTimer();
+	table.findBatch(&days[0], queries, &indices[0]);
+	double sortedSum = 0;
+	for (size_t i = 0; i < queries; ++i)
+		sortedSum += table.rateAt(indices[i]);
+	double sortedTime = timer.seconds();
+	double sortedCheck = 0;
+	for (size_t i = 0; i < queries; ++i)
+	{
+		batchMatches = batchMatches && indices[i] == table.find(days[i]);
+		sortedCheck += table.rateAt(table.find(days[i]));
+	}
+
+	// Ledgers repeat dates: draw from a few hundred distinct days, most
+	// often from the first ones, and answer through the lookup cache.
+	std::vector<int> skewed(queries);
+	for (size_t i = 0; i < queries; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		unsigned int r = (seed >> 8) % 1000u;
+		skewed[i] = first + static_cast<int>((r * r / 1000u) * 7u % static_cast<unsigned int>(range));
+	}
+	timer = BenchTimer();
+	for (size_t i = 0; i < queries; ++i)
+		indices[i] = table.find(skewed[i]);
+	double skewedTime = timer.seconds();
+	LookupCache cache;
+	std::vector<long> cached(queries);
+	timer = BenchTimer();
+	for (size_t i = 0; i < queries; i += 256)
+		cache.find(table, &skewed[i], std::min<size_t>(256, queries - i), &cached[i]);
+	double cachedTime = timer.seconds();
+	batchMatches = batchMatches && cached == indices;
+
+	std::cout << "rows: " << table.size() << ", queries: " << queries << std::endl;
+	std::cout << "std::map   : " << mapTime << " s (" << mapTime * 1e9 / queries << " ns/lookup)" << std::endl;
+	std::cout << "RateTable  : " << tableTime << " s (" << tableTime * 1e9 / queries << " ns/lookup)" << std::endl;
+	std::cout << "findBatch  : " << batchTime << " s (" << batchTime * 1e9 / queries << " ns/lookup)" << std::endl;
+	std::cout << "  sorted   : " << sortedTime << " s (" << sortedTime * 1e9 / queries << " ns/lookup)" << std::endl;
+	std::cout << "skewed     : " << skewedTime << " s (" << skewedTime * 1e9 / queries << " ns/lookup)" << std::endl;
+	std::cout << "  cached   : " << cachedTime << " s (" << cachedTime * 1e9 / queries << " ns/lookup, "
+		<< cache.hits() << " hits, " << cache.misses() << " misses)" << std::endl;
+	if (mapSum != tableSum || tableSum != batchSum || !batchMatches || sortedSum != sortedCheck)
+	{
+		std::cerr << "Error: lookup results differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "BitcoinExchange.hpp"
+#include "BenchTimer.hpp"
+
+// Times each stage of btc's input pipeline on a ledger, then the whole
+// pipeline, all in memory so that disk and terminal speed stay out of the
+// numbers:
+//
+//   split     cutting the input into lines
+//   parse     reading the value field of every line
+//   validate  checking and encoding the date field
+//   line      parseLine(), which does both plus the error classification
+//   lookup    resolving the dates of the lines parseLine() accepts
+//   format    writing the result lines for those lines
+//   pipeline  LineBatch + processBatch, as btc runs sequentially
+//
+// Usage: bench_pipeline [rates.csv] [ledger]
+
+namespace
+{
+	struct Span
+	{
+		const char *begin;
+		const char *end;
+	};
+}
+
+static void report(const char *stage, double seconds, size_t items, size_t bytes)
+{
+	std::cout << "  " << stage << std::string(10 - std::strlen(stage), ' ')
+		<< seconds << " s  " << static_cast<unsigned long>(items / seconds) << " lines/s";
+	if (bytes > 0)
+		std::cout << "  " << bytes / seconds / (1024 * 1024) << " MiB/s";
+	std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	std::string rates = argc > 1 ? argv[1] : "data.csv";
+	std::string ledger = argc > 2 ? argv[2] : "bench_ledger.txt";
+	BitcoinExchange exchange;
+	LineReader reader;
+	try
+	{
+		exchange.loadRates(rates);
+		if (!reader.open(ledger))
+			throw std::runtime_error("Error: could not open " + ledger);
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	const char *begin;
+	const char *end;
+	reader.next(begin, end);
+	if (!reader.remaining(begin, end))
+	{
+		std::cerr << "Error: " << ledger << " has no lines after its header" << std::endl;
+		return 1;
+	}
+	size_t bytes = static_cast<size_t>(end - begin);
+	int maxYear = calendar::currentYear();
+
+	BenchTimer timer;
+	std::vector<Span> lines;
+	for (const char *p = begin; p != end; )
+	{
+		const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+		Span line = { p, newline ? newline : end };
+		lines.push_back(line);
+		p = newline ? newline + 1 : end;
+	}
+	double splitTime = timer.seconds();
+
+	std::vector<Span> dates(lines.size());
+	std::vector<Span> values(lines.size());
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		const char *bar = static_cast<const char *>(std::memchr(lines[i].begin, '|', lines[i].end - lines[i].begin));
+		const char *dateEnd = bar ? bar : lines[i].end;
+		while (dateEnd != lines[i].begin && dateEnd[-1] == ' ')
+			--dateEnd;
+		dates[i].begin = lines[i].begin;
+		dates[i].end = dateEnd;
+		values[i].begin = bar ? bar + 1 : lines[i].end;
+		values[i].end = lines[i].end;
+		while (values[i].begin != values[i].end && *values[i].begin == ' ')
+			++values[i].begin;
+	}
+
+	timer = BenchTimer();
+	size_t numbers = 0;
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		const char *p = values[i].begin;
+		double value;
+		numbers += parseNumber(p, values[i].end, value);
+	}
+	double parseTime = timer.seconds();
+
+	timer = BenchTimer();
+	std::vector<int> days;
+	days.reserve(dates.size());
+	for (size_t i = 0; i < dates.size(); ++i)
+	{
+		int day;
+		if (parseDay(dates[i].begin, static_cast<size_t>(dates[i].end - dates[i].begin), day, maxYear))
+			days.push_back(day);
+	}
+	double validateTime = timer.seconds();
+
+	timer = BenchTimer();
+	std::vector<int> pricedDays;
+	std::vector<double> pricedValues;
+	pricedDays.reserve(lines.size());
+	pricedValues.reserve(lines.size());
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		ParsedLine parsed;
+		parseLine(lines[i].begin, lines[i].end, maxYear, parsed);
+		if (parsed.status == ParsedLine::OK)
+		{
+			pricedDays.push_back(parsed.day);
+			pricedValues.push_back(parsed.value);
+		}
+	}
+	double lineTime = timer.seconds();
+
+	timer = BenchTimer();
+	std::vector<double> found(pricedDays.size());
+	exchange.lookupRates(pricedDays.empty() ? NULL : &pricedDays[0], pricedDays.size(), found.empty() ? NULL : &found[0]);
+	double lookupTime = timer.seconds();
+
+	timer = BenchTimer();
+	OutputBuffer out;
+	for (size_t i = 0; i < pricedDays.size(); ++i)
+	{
+		char date[10];
+		formatDay(pricedDays[i], date);
+		out.write(OutputBuffer::OUT, date, 10);
+		out.write(OutputBuffer::OUT, " => ", 4);
+		out.writeDouble(OutputBuffer::OUT, pricedValues[i]);
+		out.write(OutputBuffer::OUT, " = ", 3);
+		out.writeDouble(OutputBuffer::OUT, pricedValues[i] * found[i]);
+		out.write(OutputBuffer::OUT, "\n", 1);
+		if ((i + 1) % LineBatch::CAPACITY == 0)
+			out.clear();
+	}
+	double formatTime = timer.seconds();
+
+	timer = BenchTimer();
+	LineBatch batch;
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		batch.add(lines[i].begin, lines[i].end, maxYear);
+		if (batch.full() || i + 1 == lines.size())
+		{
+			exchange.processBatch(batch, out);
+			out.clear();
+		}
+	}
+	double pipelineTime = timer.seconds();
+
+	std::cout << ledger << ": " << lines.size() << " lines, " << bytes << " bytes, "
+		<< numbers << " numbers, " << days.size() << " valid dates, " << pricedDays.size() << " priced" << std::endl;
+	report("split", splitTime, lines.size(), bytes);
+	report("parse", parseTime, values.size(), 0);
+	report("validate", validateTime, dates.size(), 0);
+	report("line", lineTime, lines.size(), bytes);
+	report("lookup", lookupTime, pricedDays.size(), 0);
+	report("format", formatTime, pricedDays.size(), 0);
+	report("pipeline", pipelineTime, lines.size(), bytes);
+	return 0;
+}
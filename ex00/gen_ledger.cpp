@@ -0,0 +1,165 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Date.hpp"
+
+// Writes a synthetic btc ledger to stdout. The output depends only on the
+// options, so benchmark runs are reproducible.
+//
+//   gen_ledger LINES [--seed N] [--from DATE] [--to DATE]
+//                    [--dates uniform|recent] [--errors RATE] [--repeat RATE]
+//
+// --dates recent draws most dates from the end of the range, as a live
+// ledger would. --errors is the share of lines that btc must reject, spread
+// over every kind of error it reports. --repeat is the share of valid lines
+// that reuse one of a small set of hot dates.
+
+namespace
+{
+	class Random
+	{
+	public:
+		explicit Random(unsigned long long seed) : _state(seed * 2654435761ULL + 1) {}
+
+		// xorshift64*
+		unsigned long long next()
+		{
+			_state ^= _state >> 12;
+			_state ^= _state << 25;
+			_state ^= _state >> 27;
+			return _state * 2685821657736338717ULL;
+		}
+		double uniform() { return static_cast<double>(next() >> 11) / 9007199254740992.0; }
+		unsigned int below(unsigned int n) { return static_cast<unsigned int>(uniform() * n); }
+
+	private:
+		unsigned long long _state;
+	};
+
+	struct Options
+	{
+		unsigned long lines;
+		unsigned long long seed;
+		int from;
+		int to;
+		bool recent;
+		double errors;
+		double repeat;
+	};
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+	if (argc < 2)
+		return false;
+	char *end;
+	options.lines = std::strtoul(argv[1], &end, 10);
+	if (*end != '\0')
+		return false;
+	options.seed = 42;
+	options.recent = false;
+	options.errors = 0.05;
+	options.repeat = 0.3;
+	if (!parseDay("2009-01-02", options.from) || !parseDay("2022-03-29", options.to))
+		return false;
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		const char *value = argv[i + 1];
+		if (option == "--seed")
+			options.seed = std::strtoull(value, NULL, 10);
+		else if (option == "--from" && parseDay(value, std::strlen(value), options.from))
+			;
+		else if (option == "--to" && parseDay(value, std::strlen(value), options.to))
+			;
+		else if (option == "--dates" && (std::strcmp(value, "uniform") == 0 || std::strcmp(value, "recent") == 0))
+			options.recent = std::strcmp(value, "recent") == 0;
+		else if (option == "--errors")
+			options.errors = std::atof(value);
+		else if (option == "--repeat")
+			options.repeat = std::atof(value);
+		else
+			return false;
+	}
+	return (argc % 2 == 0) && options.from <= options.to;
+}
+
+static int drawDay(Random &random, const Options &options)
+{
+	unsigned int span = static_cast<unsigned int>(options.to - options.from) + 1;
+	if (!options.recent)
+		return options.from + static_cast<int>(random.below(span));
+	// Squaring a uniform draw piles the dates up towards the end.
+	double u = random.uniform();
+	return options.to - static_cast<int>(u * u * (span - 1));
+}
+
+static void writeLine(Random &random, const Options &options, const std::vector<int> &hot, std::string &out)
+{
+	char date[11];
+	char line[96];
+	int length;
+	int day = random.uniform() < options.repeat ? hot[random.below(static_cast<unsigned int>(hot.size()))]
+		: drawDay(random, options);
+	formatDay(day, date);
+	date[10] = '\0';
+	if (random.uniform() >= options.errors)
+	{
+		if (random.below(4) == 0)
+			length = std::snprintf(line, sizeof(line), "%s | %u\n", date, random.below(1001));
+		else
+			length = std::snprintf(line, sizeof(line), "%s | %.2f\n", date, random.uniform() * 1000);
+		out.append(line, static_cast<size_t>(length));
+		return;
+	}
+	switch (random.below(5))
+	{
+		case 0:
+			length = std::snprintf(line, sizeof(line), "%.4s-13-%.2s | 1\n", date, date + 8);
+			break;
+		case 1:
+			length = std::snprintf(line, sizeof(line), "%s | -%u\n", date, 1 + random.below(100));
+			break;
+		case 2:
+			length = std::snprintf(line, sizeof(line), "%s | %u\n", date, 1001 + random.below(1u << 30));
+			break;
+		case 3:
+			length = std::snprintf(line, sizeof(line), "%s\n", date);
+			break;
+		default:
+			length = std::snprintf(line, sizeof(line), "%s | 1.5x\n", date);
+			break;
+	}
+	out.append(line, static_cast<size_t>(length));
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "usage: " << argv[0] << " LINES [--seed N] [--from DATE] [--to DATE]"
+			" [--dates uniform|recent] [--errors RATE] [--repeat RATE]" << std::endl;
+		return 1;
+	}
+	Random random(options.seed);
+	std::vector<int> hot(32);
+	for (size_t i = 0; i < hot.size(); ++i)
+		hot[i] = drawDay(random, options);
+
+	std::string out = "date | value\n";
+	for (unsigned long i = 0; i < options.lines; ++i)
+	{
+		writeLine(random, options, hot, out);
+		if (out.size() >= 1 << 20)
+		{
+			std::fwrite(out.data(), 1, out.size(), stdout);
+			out.clear();
+		}
+	}
+	std::fwrite(out.data(), 1, out.size(), stdout);
+	return std::fflush(stdout) == 0 ? 0 : 1;
+}
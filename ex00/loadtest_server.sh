@@ -0,0 +1,71 @@
+#!/bin/bash
+
+# Load test for the btc query server: starts a server, runs several clients
+# in parallel against it, checks every answer against a plain btc run and
+# reports throughput. Usage: ./loadtest_server.sh [clients] [lines per client]
+
+EXEC=./btc
+SOCKET=/tmp/btc_loadtest.sock
+CLIENTS=${1:-8}
+LINES=${2:-100000}
+WORKDIR=$(mktemp -d)
+
+GREEN="\\033[1;32m"
+RED="\\033[1;31m"
+NC="\\033[0m"
+
+cleanup() {
+	[ -n "$SERVER_PID" ] && kill "$SERVER_PID" 2>/dev/null && wait "$SERVER_PID" 2>/dev/null
+	rm -rf "$WORKDIR"
+}
+trap cleanup EXIT
+
+# Query lines: mostly valid dates across the table, plus some bad input.
+awk -v n="$LINES" 'BEGIN {
+	srand(42);
+	for (i = 0; i < n; i++) {
+		r = rand();
+		if (r < 0.05)
+			print "2012-13-01 | 1";
+		else if (r < 0.08)
+			print "2013-05-01 | -" int(rand() * 10);
+		else
+			printf "%04d-%02d-%02d | %.2f\n", 2009 + int(rand() * 13), 1 + int(rand() * 12), 1 + int(rand() * 28), rand() * 1000;
+	}
+}' > "$WORKDIR/queries.txt"
+
+# Reference answers from the command line tool (skipping its header error);
+# --strict keeps its errors interleaved with the results like the server.
+{ echo "date | value"; cat "$WORKDIR/queries.txt"; } > "$WORKDIR/input.txt"
+$EXEC --strict "$WORKDIR/input.txt" > "$WORKDIR/expected.txt" 2>&1
+
+$EXEC --serve "$SOCKET" data.csv 2>/dev/null &
+SERVER_PID=$!
+for i in $(seq 50); do
+	[ -S "$SOCKET" ] && break
+	sleep 0.1
+done
+
+echo "=== $CLIENTS clients x $LINES queries ==="
+START=$(date +%s.%N)
+PIDS=()
+for c in $(seq "$CLIENTS"); do
+	$EXEC --client "$SOCKET" "$WORKDIR/queries.txt" > "$WORKDIR/answers_$c.txt" &
+	PIDS+=($!)
+done
+wait "${PIDS[@]}"
+END=$(date +%s.%N)
+
+FAILED=0
+for c in $(seq "$CLIENTS"); do
+	if ! cmp -s "$WORKDIR/answers_$c.txt" "$WORKDIR/expected.txt"; then
+		echo -e "❌ ${RED}FAIL${NC}: client $c answers differ from btc"
+		FAILED=1
+	fi
+done
+[ "$FAILED" -eq 0 ] && echo -e "✅ ${GREEN}PASS${NC}: all answers match btc"
+
+awk -v s="$START" -v e="$END" -v n=$((CLIENTS * LINES)) 'BEGIN {
+	printf "%d queries in %.3f s (%.0f queries/s)\n", n, e - s, n / (e - s);
+}'
+exit $FAILED
@@ -7,19 +7,112 @@
 #include <algorithm>
 #include <exception>
 #include <sys/stat.h>
+#include <vector>
+#include <cerrno>
 #include "BitcoinExchange.hpp"
+#include "RateServer.hpp"
+
+// More threads than this only add scheduling and memory overhead.
+static const unsigned long MAX_THREADS = 256;
+
+static bool parseThreads(const char *arg, BitcoinExchange &be)
+{
+	char *end;
+	errno = 0;
+	unsigned long threads = std::strtoul(arg, &end, 10);
+	if (*arg < '0' || *arg > '9' || *end != '\0' || errno == ERANGE || threads > MAX_THREADS)
+	{
+		std::cerr << "Error: -j takes a thread count from 0 to " << MAX_THREADS << "." << std::endl;
+		return false;
+	}
+	be.setThreads(threads ? static_cast<unsigned int>(threads) : std::thread::hardware_concurrency());
+	return true;
+}
 
 int main(int argc, char **argv)
 {
-	if (argc != 2)
+	BitcoinExchange be;
+	std::string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--build-snapshot" || mode == "--check-snapshot")
+	{
+		try
+		{
+			if (mode == "--build-snapshot")
+				be.buildSnapshot(argc > 2 ? argv[2] : "data.csv");
+			else
+				be.checkSnapshot(argc > 2 ? argv[2] : "data.csv");
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	if ((mode == "--serve" || mode == "--client") && argc >= 3)
+	{
+		try
+		{
+			if (mode == "--client")
+				return runClient(argv[2], argc > 3 ? argv[3] : "-");
+			RateServer server(argv[2], argc > 3 ? argv[3] : "data.csv");
+			server.run();
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	std::string input;
+	std::vector<std::string> rateFiles;
+	std::string stats;
+	bool badUsage = false;
+	for (int i = 1; i < argc && !badUsage; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-j" && i + 1 < argc)
+		{
+			if (!parseThreads(argv[++i], be))
+				return 1;
+		}
+		else if (arg == "--strict")
+			be.setStrictOrder(true);
+		else if (arg == "--stats" || arg == "--stats=json")
+			stats = arg;
+		else if (arg == "--rates" && i + 1 < argc)
+			rateFiles.push_back(argv[++i]);
+		else if (input.empty())
+			input = arg;
+		else
+			badUsage = true;
+	}
+	if (badUsage || input.empty())
 	{
 		std::cerr << "Error: could not open file." << std::endl;
 		return 1;
 	}
-	BitcoinExchange be;
 	try
 	{
-		be.run(argv[1]);
+		if (rateFiles.empty())
+			be.run(input);
+		else
+		{
+			// "--rates NAME=FILE" names the asset of a single-column file;
+			// otherwise the asset names come from the file's header.
+			for (size_t i = 0; i < rateFiles.size(); ++i)
+			{
+				size_t equals = rateFiles[i].find('=');
+				if (equals != std::string::npos && rateFiles[i].find('/') > equals)
+					be.loadRates(rateFiles[i].substr(equals + 1), rateFiles[i].substr(0, equals));
+				else
+					be.loadRates(rateFiles[i]);
+			}
+			be.readAndProcessInput(input);
+		}
+		if (!stats.empty())
+			be.writeStats(std::cerr, stats == "--stats=json");
 	}
 	catch (std::exception &e)
 	{
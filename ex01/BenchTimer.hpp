@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+
+// Wall-clock stopwatch for bench_rpn, bench_numbers and fuzz_rpn, started on
+// construction; assigning a fresh BenchTimer restarts it.
+class BenchTimer
+{
+    public:
+        BenchTimer() : _start(std::chrono::steady_clock::now()) {}
+        double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+    private:
+        std::chrono::steady_clock::time_point _start;
+};
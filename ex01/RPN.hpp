@@ -1,10 +1,12 @@
 #pragma once
 
 #include <iostream>
-#include <stack>
 #include <string>
-#include <sstream>
+#include "RPNProgram.hpp"
+#include "RPNEvaluator.hpp"
 
+// Compiles the expression into an RPNProgram and runs it. Every call
+// starts from an empty stack.
 class RPN
 {
     public:
@@ -16,7 +18,8 @@ class RPN
         void printStack();
 
     private:
-        std::stack<float> _stack;
+        RPNProgram _program;
+        RPNEvaluator _evaluator;
         float _result;
         bool _error;
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "RPNBatch.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+const size_t RPNBatch::CHUNK_BYTES;
+
+RPNBatch::RPNBatch(unsigned int threads)
+{
+    _threads = threads ? threads : 1;
+}
+
+// Reads whole lines until the chunk holds CHUNK_BYTES. Every line is stored
+// with a '\n', including a last line that had none.
+bool RPNBatch::readChunk(std::istream &in, std::string &text)
+{
+    std::string line;
+
+    text.clear();
+    while (text.size() < CHUNK_BYTES && std::getline(in, line))
+    {
+        text += line;
+        text += '\n';
+    }
+    return !text.empty();
+}
+
+size_t RPNBatch::evaluateChunk(const std::string &text, std::string &output,
+    RPNProgram &program, RPNEvaluator &evaluator)
+{
+    const char *p = text.data();
+    const char *end = p + text.size();
+    size_t failed = 0;
+    char number[32];
+
+    output.clear();
+    while (p != end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        program.compile(p, newline);
+        float result = evaluator.run(program);
+        if (program.ok())
+        {
+            // "%g" is what operator<< prints for a float by default.
+            int length = std::snprintf(number, sizeof(number), "%g\n", static_cast<double>(result));
+            output.append(number, static_cast<size_t>(length));
+        }
+        else
+        {
+            output += "Error\n";
+            ++failed;
+        }
+        p = newline + 1;
+    }
+    return failed;
+}
+
+size_t RPNBatch::run(std::istream &in, std::ostream &out)
+{
+    size_t failed = 0;
+
+    if (_threads == 1)
+    {
+        RPNProgram program;
+        RPNEvaluator evaluator;
+        std::string text;
+        std::string output;
+        while (readChunk(in, text))
+        {
+            failed += evaluateChunk(text, output, program, evaluator);
+            out << output;
+        }
+        out.flush();
+        return failed;
+    }
+
+    // Chunk n lives in slot n % window. This thread reads chunks into free
+    // slots and writes the oldest one as soon as it is done; workers take
+    // the chunks in order.
+    const size_t window = _threads * 2;
+    std::vector<Chunk> slots(window);
+    size_t read = 0;
+    size_t next = 0;
+    size_t written = 0;
+    bool finished = false;
+    std::mutex mutex;
+    std::condition_variable chunkReady;
+    std::condition_variable chunkDone;
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < _threads; ++t)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            RPNProgram program;
+            RPNEvaluator evaluator;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                while (next == read && !finished)
+                    chunkReady.wait(lock);
+                if (next == read)
+                    return;
+                Chunk &chunk = slots[next++ % window];
+                lock.unlock();
+                chunk.failed = evaluateChunk(chunk.text, chunk.output, program, evaluator);
+                lock.lock();
+                chunk.done = true;
+                chunkDone.notify_all();
+            }
+        }));
+    }
+
+    bool eof = false;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        if (written < read && slots[written % window].done)
+        {
+            Chunk &chunk = slots[written % window];
+            lock.unlock();
+            out << chunk.output;
+            lock.lock();
+            failed += chunk.failed;
+            ++written;
+        }
+        else if (!eof && read < written + window)
+        {
+            // The slot is free: no worker touches it until read moves past it.
+            Chunk &chunk = slots[read % window];
+            lock.unlock();
+            eof = !readChunk(in, chunk.text);
+            lock.lock();
+            chunk.done = false;
+            if (!eof)
+            {
+                ++read;
+                chunkReady.notify_one();
+            }
+        }
+        else if (written < read)
+            chunkDone.wait(lock);
+        else
+            break;
+    }
+    finished = true;
+    chunkReady.notify_all();
+    lock.unlock();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    out.flush();
+    return failed;
+}
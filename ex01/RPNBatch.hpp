@@ -0,0 +1,38 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstddef>
+#include "RPNProgram.hpp"
+#include "RPNEvaluator.hpp"
+
+// Evaluates a stream of newline-separated expressions, one result line per
+// expression: the value as RPN prints it, or "Error". Lines are cut into
+// chunks that a pool of workers evaluates, each with its own program and
+// evaluator; finished chunks are written in input order. At most a window
+// of chunks is in flight, so the memory used does not grow with the input.
+class RPNBatch
+{
+    public:
+        static const size_t CHUNK_BYTES = 64 * 1024;
+
+        explicit RPNBatch(unsigned int threads);
+
+        // Returns the number of expressions that failed.
+        size_t run(std::istream &in, std::ostream &out);
+
+    private:
+        struct Chunk
+        {
+            std::string text;
+            std::string output;
+            size_t failed;
+            bool done;
+        };
+
+        static bool readChunk(std::istream &in, std::string &text);
+        static size_t evaluateChunk(const std::string &text, std::string &output,
+            RPNProgram &program, RPNEvaluator &evaluator);
+
+        unsigned int _threads;
+};
@@ -0,0 +1,176 @@
+#include "RPNColumnEvaluator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+const size_t RPNColumnEvaluator::BLOCK;
+
+// One loop per operator, so that each one vectorizes on its own. out may be
+// b itself: every element is read before it is written.
+static void apply(unsigned char op, const float *b, const float *a, float *out, size_t n)
+{
+    switch (op)
+    {
+        case RPNProgram::ADD:
+            for (size_t i = 0; i < n; ++i)
+                out[i] = b[i] + a[i];
+            break;
+        case RPNProgram::SUB:
+            for (size_t i = 0; i < n; ++i)
+                out[i] = b[i] - a[i];
+            break;
+        case RPNProgram::MUL:
+            for (size_t i = 0; i < n; ++i)
+                out[i] = b[i] * a[i];
+            break;
+        default:
+            for (size_t i = 0; i < n; ++i)
+                out[i] = b[i] / a[i];
+            break;
+    }
+}
+
+void RPNColumnEvaluator::run(const RPNProgram &program, const float *const *columns, size_t rows, float *results)
+{
+    size_t buffers = program.maxDepth() + program.temporaries();
+    if (_buffers.size() < buffers * BLOCK)
+        _buffers.resize(buffers * BLOCK);
+    if (_stack.size() < program.maxDepth())
+        _stack.resize(program.maxDepth());
+
+    std::vector<const float *> offset(columns, columns + program.variables().size());
+    for (size_t start = 0; start < rows; start += BLOCK)
+    {
+        for (size_t v = 0; v < offset.size(); ++v)
+            offset[v] = columns[v] + start;
+        runBlock(program, offset.empty() ? NULL : &offset[0], std::min(BLOCK, rows - start), results + start);
+    }
+}
+
+// Stack entries point into a column, for a variable, into the buffer of a
+// temporary, or at the block buffer that belongs to their depth, for a
+// constant or a result. The temporaries' buffers follow the stack's.
+void RPNColumnEvaluator::runBlock(const RPNProgram &program, const float *const *columns, size_t rows, float *results)
+{
+    const RPNProgram::Instruction *pc = program.code();
+    const RPNProgram::Instruction *end = pc + program.size();
+    float *temporaries = &_buffers[program.maxDepth() * BLOCK];
+    size_t top = 0;
+
+    for (; pc != end; ++pc)
+    {
+        float *slot;
+        switch (pc->op)
+        {
+            case RPNProgram::PUSH:
+            case RPNProgram::CONST:
+                slot = &_buffers[top * BLOCK];
+                std::fill(slot, slot + rows, pc->op == RPNProgram::PUSH ? static_cast<float>(pc->operand)
+                    : program.constants()[pc->operand]);
+                _stack[top++] = slot;
+                break;
+            case RPNProgram::LOAD:
+                _stack[top++] = columns[pc->operand];
+                break;
+            case RPNProgram::FETCH:
+                _stack[top++] = temporaries + pc->operand * BLOCK;
+                break;
+            case RPNProgram::STORE:
+                std::copy(_stack[top - 1], _stack[top - 1] + rows, temporaries + pc->operand * BLOCK);
+                break;
+            default:
+                slot = &_buffers[(top - 2) * BLOCK];
+                --top;
+                apply(pc->op, _stack[top - 1], _stack[top], slot, rows);
+                _stack[top - 1] = slot;
+                break;
+        }
+    }
+    std::copy(_stack[0], _stack[0] + rows, results);
+}
+
+static bool parseRow(const std::string &line, std::vector<float> &values)
+{
+    const char *p = line.c_str();
+
+    values.clear();
+    while (true)
+    {
+        while (std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if (*p == '\0')
+            return true;
+        char *end;
+        values.push_back(std::strtof(p, &end));
+        if (end == p || (*end != '\0' && !std::isspace(static_cast<unsigned char>(*end))))
+            return false;
+        p = end;
+    }
+}
+
+size_t RPNColumnEvaluator::evaluateTable(const RPNProgram &program, std::istream &in, std::ostream &out)
+{
+    const size_t tableRows = 64 * BLOCK;
+    std::string line;
+    std::vector<std::string> header;
+
+    if (std::getline(in, line))
+    {
+        std::string name;
+        std::istringstream names(line);
+        while (names >> name)
+            header.push_back(name);
+    }
+    std::vector<size_t> fields;
+    for (size_t v = 0; v < program.variables().size(); ++v)
+    {
+        size_t field = std::find(header.begin(), header.end(), program.variables()[v]) - header.begin();
+        if (field == header.size())
+            throw std::string("Unknown variable " + program.variables()[v]);
+        fields.push_back(field);
+    }
+
+    std::vector<std::vector<float> > columns(fields.size(), std::vector<float>(tableRows));
+    std::vector<const float *> pointers(fields.size());
+    for (size_t v = 0; v < fields.size(); ++v)
+        pointers[v] = &columns[v][0];
+    std::vector<float> results(tableRows);
+    std::vector<char> failedRows(tableRows);
+    std::vector<float> values;
+    size_t failed = 0;
+    char number[32];
+    std::string output;
+    bool more = true;
+    while (more)
+    {
+        size_t rows = 0;
+        while (rows < tableRows && (more = static_cast<bool>(std::getline(in, line))))
+        {
+            bool bad = !parseRow(line, values) || values.size() != header.size();
+            for (size_t v = 0; v < fields.size(); ++v)
+                columns[v][rows] = bad ? 0 : values[fields[v]];
+            failedRows[rows++] = bad;
+        }
+        run(program, pointers.empty() ? NULL : &pointers[0], rows, &results[0]);
+        output.clear();
+        for (size_t row = 0; row < rows; ++row)
+        {
+            if (failedRows[row])
+            {
+                output += "Error\n";
+                ++failed;
+                continue;
+            }
+            // "%g" is what operator<< prints for a float by default.
+            int length = std::snprintf(number, sizeof(number), "%g\n", static_cast<double>(results[row]));
+            output.append(number, static_cast<size_t>(length));
+        }
+        out << output;
+    }
+    out.flush();
+    return failed;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include "RPNProgram.hpp"
+
+// Runs one compiled program over whole columns of variable values. Rows are
+// taken BLOCK at a time and each instruction is applied to the whole block
+// before the next one, so every operator is a plain loop over float arrays
+// that the compiler can vectorize. The results are the ones RPNEvaluator
+// gives row by row: the same float operations in the same order.
+class RPNColumnEvaluator
+{
+    public:
+        static const size_t BLOCK = 1024;
+
+        // columns[i] holds rows values of program.variables()[i]. The program
+        // must be ok().
+        void run(const RPNProgram &program, const float *const *columns, size_t rows, float *results);
+
+        // Reads a table whose first line names the columns and whose other
+        // lines hold one number per column, and writes one line per row: the
+        // result, or "Error" for a row that does not parse. Throws a
+        // std::string if the program uses a variable the header lacks.
+        // Returns the number of rows that failed.
+        size_t evaluateTable(const RPNProgram &program, std::istream &in, std::ostream &out);
+
+    private:
+        void runBlock(const RPNProgram &program, const float *const *columns, size_t rows, float *results);
+
+        std::vector<float> _buffers;
+        std::vector<const float *> _stack;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "RPNProgram.hpp"
+#include "RPNNumbers.hpp"
+
+// Runs compiled programs over an array stack of Policy::Value (see
+// RPNNumbers.hpp). Each policy gets its own instantiation, so the float
+// evaluator carries none of the checks the exact ones make.
+//
+// Programs up to CAPACITY deep use the fixed array inside the evaluator;
+// deeper ones use a spill buffer that is grown once and then reused, so
+// repeated runs never allocate. An evaluator is not shared: give each
+// thread its own.
+template <class Policy>
+class BasicRPNEvaluator
+{
+    public:
+        typedef typename Policy::Value Value;
+
+        static const size_t CAPACITY = 256;
+
+        BasicRPNEvaluator();
+        BasicRPNEvaluator(const BasicRPNEvaluator &other);
+        BasicRPNEvaluator &operator=(const BasicRPNEvaluator &other);
+
+        // Runs the program's code and returns the value on top of the stack
+        // (a default Value if it is empty). Only meaningful when program.ok()
+        // and error() is NONE afterwards. variables holds one value per name
+        // in program.variables().
+        Value run(const RPNProgram &program, const Value *variables = NULL);
+
+        // Why the last run stopped early: NONE, or an error from the policy.
+        RPNProgram::Error error() const;
+
+        // The stack as the last run left it, bottom first.
+        const Value *stack() const;
+        size_t depth() const;
+
+    private:
+        Value _fixed[CAPACITY];
+        std::vector<Value> _spill;
+        Value *_stack;
+        size_t _depth;
+        RPNProgram::Error _error;
+};
+
+typedef BasicRPNEvaluator<FloatPolicy> RPNEvaluator;
+
+#include "RPNEvaluator.tpp"
@@ -0,0 +1,118 @@
+#include <algorithm>
+
+template <class Policy>
+const size_t BasicRPNEvaluator<Policy>::CAPACITY;
+
+template <class Policy>
+BasicRPNEvaluator<Policy>::BasicRPNEvaluator()
+{
+    _stack = _fixed;
+    _depth = 0;
+    _error = RPNProgram::NONE;
+}
+
+template <class Policy>
+BasicRPNEvaluator<Policy>::BasicRPNEvaluator(const BasicRPNEvaluator &other)
+{
+    _stack = _fixed;
+    _depth = 0;
+    *this = other;
+}
+
+template <class Policy>
+BasicRPNEvaluator<Policy> &BasicRPNEvaluator<Policy>::operator=(const BasicRPNEvaluator &other)
+{
+    if (this == &other)
+        return *this;
+    _spill = other._spill;
+    _depth = other._depth;
+    _error = other._error;
+    if (other._stack == other._fixed)
+    {
+        _stack = _fixed;
+        std::copy(other._fixed, other._fixed + _depth, _fixed);
+    }
+    else
+        _stack = &_spill[0];
+    return *this;
+}
+
+// The temporaries of an optimized program live just above its stack.
+template <class Policy>
+typename BasicRPNEvaluator<Policy>::Value BasicRPNEvaluator<Policy>::run(const RPNProgram &program, const Value *variables)
+{
+    size_t needed = program.maxDepth() + program.temporaries();
+    if (needed <= CAPACITY)
+        _stack = _fixed;
+    else
+    {
+        if (_spill.size() < needed)
+            _spill.resize(needed);
+        _stack = &_spill[0];
+    }
+
+    const RPNProgram::Instruction *pc = program.code();
+    const RPNProgram::Instruction *end = pc + program.size();
+    const float *constants = program.constants().empty() ? NULL : &program.constants()[0];
+    Value *temporaries = _stack + program.maxDepth();
+    Value *top = _stack;
+    RPNProgram::Error error = RPNProgram::NONE;
+    for (; pc != end && error == RPNProgram::NONE; ++pc)
+    {
+        switch (pc->op)
+        {
+            case RPNProgram::PUSH:
+                *top++ = Policy::digit(pc->operand);
+                break;
+            case RPNProgram::LOAD:
+                *top++ = variables[pc->operand];
+                break;
+            case RPNProgram::CONST:
+                error = Policy::constant(constants[pc->operand], *top++);
+                break;
+            case RPNProgram::FETCH:
+                *top++ = temporaries[pc->operand];
+                break;
+            case RPNProgram::STORE:
+                temporaries[pc->operand] = top[-1];
+                break;
+            case RPNProgram::ADD:
+                --top;
+                error = Policy::add(top[-1], top[0]);
+                break;
+            case RPNProgram::SUB:
+                --top;
+                error = Policy::sub(top[-1], top[0]);
+                break;
+            case RPNProgram::MUL:
+                --top;
+                error = Policy::mul(top[-1], top[0]);
+                break;
+            default:
+                --top;
+                error = Policy::div(top[-1], top[0]);
+                break;
+        }
+    }
+    _error = error;
+    _depth = static_cast<size_t>(top - _stack);
+    return _depth ? top[-1] : Value();
+}
+
+template <class Policy>
+RPNProgram::Error BasicRPNEvaluator<Policy>::error() const
+{
+    return _error;
+}
+
+template <class Policy>
+const typename BasicRPNEvaluator<Policy>::Value *BasicRPNEvaluator<Policy>::stack() const
+{
+    return _stack;
+}
+
+template <class Policy>
+size_t BasicRPNEvaluator<Policy>::depth() const
+{
+    return _depth;
+}
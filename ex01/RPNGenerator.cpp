@@ -0,0 +1,183 @@
+#include "RPNGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static bool isOperator(const std::string &token)
+{
+    return token.size() == 1 && std::strchr("+-*/", token[0]);
+}
+
+RPNGenerator::RPNGenerator(const Options &options)
+{
+    _options = options;
+    _options.depth = std::max<size_t>(_options.depth, 2);
+    _state = options.seed * 2654435761ULL + 1;
+    _tokens = 0;
+}
+
+// xorshift64*
+unsigned long long RPNGenerator::random()
+{
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    return _state * 2685821657736338717ULL;
+}
+
+size_t RPNGenerator::below(size_t n)
+{
+    return static_cast<size_t>((random() >> 11) % n);
+}
+
+std::string RPNGenerator::operand()
+{
+    std::string digit(1, static_cast<char>('0' + below(10)));
+
+    switch (below(20))
+    {
+        case 0:
+            return "+" + digit;
+        case 1:
+            return "0" + digit;
+        case 2:
+            return digit + "abc";
+        case 3:
+            return digit == "0" ? "-0" : digit;
+        default:
+            return digit;
+    }
+}
+
+std::string RPNGenerator::separator()
+{
+    static const char *separators[] = { "  ", "\t", " \t " };
+
+    return below(8) ? " " : separators[below(3)];
+}
+
+void RPNGenerator::valid(std::vector<std::string> &tokens)
+{
+    static const char *operators[] = { "+", "-", "*", "/" };
+    size_t depth = 0;
+
+    tokens.clear();
+    for (size_t i = 0; i < _options.tokens || depth != 1; ++i)
+    {
+        size_t remaining = i < _options.tokens ? _options.tokens - i : 0;
+        bool reduce = depth >= 2 && (depth >= _options.depth || remaining < depth || below(2) == 0);
+        if (reduce)
+        {
+            tokens.push_back(operators[below(4)]);
+            --depth;
+        }
+        else
+        {
+            tokens.push_back(operand());
+            ++depth;
+        }
+    }
+}
+
+RPNProgram::Error RPNGenerator::next(std::string &expression)
+{
+    static const char *outOfRange[] = { "10", "42", "-1", "-9", "2.5", "1.", "0.0", "2147483647" };
+    static const char *notNumbers[] = { "a", "x1", "(1", "++", ".5", "#", "*2", "nan", "99999999999", "-2147483649" };
+    std::vector<std::string> tokens;
+    RPNProgram::Error error = RPNProgram::NONE;
+
+    valid(tokens);
+    if (static_cast<double>(random() >> 11) / 9007199254740992.0 < _options.invalid)
+    {
+        std::vector<size_t> candidates;
+        size_t depth = 0;
+        switch (below(4))
+        {
+            case 0:
+                // An operator where fewer than two values are stacked.
+                for (size_t i = 0; i < tokens.size(); ++i)
+                {
+                    if (depth < 2)
+                        candidates.push_back(i);
+                    if (isOperator(tokens[i]))
+                        --depth;
+                    else
+                        ++depth;
+                }
+                tokens.insert(tokens.begin() + candidates[below(candidates.size())], "+-*/"[below(4)] + std::string());
+                error = RPNProgram::UNDERFLOW;
+                break;
+            case 1:
+            case 2:
+                for (size_t i = 0; i < tokens.size(); ++i)
+                {
+                    if (!isOperator(tokens[i]))
+                        candidates.push_back(i);
+                }
+                if (below(2))
+                {
+                    tokens[candidates[below(candidates.size())]] = outOfRange[below(sizeof(outOfRange) / sizeof(*outOfRange))];
+                    error = RPNProgram::OUT_OF_RANGE;
+                }
+                else
+                {
+                    tokens[candidates[below(candidates.size())]] = notNumbers[below(sizeof(notNumbers) / sizeof(*notNumbers))];
+                    error = RPNProgram::NOT_A_NUMBER;
+                }
+                break;
+            default:
+                // A value left over, or nothing at all.
+                if (below(8) == 0)
+                    tokens.clear();
+                else
+                    tokens.push_back(operand());
+                error = RPNProgram::UNBALANCED;
+                break;
+        }
+    }
+
+    expression.clear();
+    if (below(16) == 0)
+        expression += separator();
+    for (size_t i = 0; i < tokens.size(); ++i)
+    {
+        if (i > 0)
+            expression += separator();
+        expression += tokens[i];
+    }
+    _tokens = tokens.size();
+    return error;
+}
+
+void RPNGenerator::mutate(std::string &expression)
+{
+    static const char alphabet[] = "0123456789+-*/ .\tae(";
+
+    for (size_t edits = 1 + below(3); edits > 0; --edits)
+    {
+        char byte = below(4) ? alphabet[below(sizeof(alphabet) - 1)] : static_cast<char>(1 + below(255));
+        size_t at = below(expression.size() + 1);
+        switch (below(3))
+        {
+            case 0:
+                if (at < expression.size())
+                {
+                    expression[at] = byte;
+                    break;
+                }
+                // fall through
+            case 1:
+                expression.insert(expression.begin() + at, byte);
+                break;
+            default:
+                if (at < expression.size())
+                    expression.erase(at, 1);
+                break;
+        }
+    }
+}
+
+size_t RPNGenerator::tokens() const
+{
+    return _tokens;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "RPNProgram.hpp"
+
+// Random RPN expressions for bench_rpn and fuzz_rpn. The output depends
+// only on the options, so runs are reproducible.
+//
+// A valid expression has about Options::tokens tokens and never holds more
+// than Options::depth values on the stack. Operands are digits, sometimes
+// spelled the odd ways RPN accepts ("+7", "07", "7abc"), and tokens are
+// separated by runs of spaces and tabs. An invalid expression is a valid one
+// with a single defect, placed so that it is the first error RPN meets; the
+// error it must report is known.
+class RPNGenerator
+{
+    public:
+        struct Options
+        {
+            size_t tokens;
+            size_t depth;
+            double invalid;     // share of invalid expressions
+            unsigned long long seed;
+        };
+
+        explicit RPNGenerator(const Options &options);
+
+        // Writes the next expression and returns the error RPN must report
+        // for it, or NONE.
+        RPNProgram::Error next(std::string &expression);
+
+        // Overwrites, inserts or deletes a few random bytes of the expression.
+        // What RPN makes of the result is not known in advance.
+        void mutate(std::string &expression);
+
+        // Whitespace-separated tokens in the last expression next() wrote.
+        size_t tokens() const;
+
+    private:
+        unsigned long long random();
+        size_t below(size_t n);
+        std::string operand();
+        std::string separator();
+        void valid(std::vector<std::string> &tokens);
+
+        Options _options;
+        unsigned long long _state;
+        size_t _tokens;
+};
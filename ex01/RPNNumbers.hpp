@@ -0,0 +1,181 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include "RPNProgram.hpp"
+
+// The kinds of numbers BasicRPNEvaluator can compute with. A policy names
+// its Value type and the operations on it; every operation returns NONE or
+// the error that stops the evaluation. The float and double policies never
+// fail, so once inlined their checks cost nothing, while the exact ones
+// report what IEEE arithmetic would hide:
+//
+//   DIVISION_BY_ZERO  a division by 0
+//   OVERFLOW          a result the type cannot hold
+//   INEXACT           a quotient that is not an integer (int64), or a CONST
+//                     that RPNOptimizer folded in float
+//
+// Only FloatPolicy runs optimized programs: their constants were computed
+// in float.
+struct FloatPolicy
+{
+    typedef float Value;
+
+    static const char *name() { return "float"; }
+    static Value digit(unsigned int digit) { return static_cast<Value>(digit); }
+    static RPNProgram::Error constant(float constant, Value &value) { value = constant; return RPNProgram::NONE; }
+    static RPNProgram::Error add(Value &b, Value a) { b = b + a; return RPNProgram::NONE; }
+    static RPNProgram::Error sub(Value &b, Value a) { b = b - a; return RPNProgram::NONE; }
+    static RPNProgram::Error mul(Value &b, Value a) { b = b * a; return RPNProgram::NONE; }
+    // Division by zero is not an error: it gives inf or nan.
+    static RPNProgram::Error div(Value &b, Value a) { b = b / a; return RPNProgram::NONE; }
+    static void print(std::ostream &out, Value value) { out << value; }
+};
+
+struct DoublePolicy
+{
+    typedef double Value;
+
+    static const char *name() { return "double"; }
+    static Value digit(unsigned int digit) { return static_cast<Value>(digit); }
+    static RPNProgram::Error constant(float, Value &) { return RPNProgram::INEXACT; }
+    static RPNProgram::Error add(Value &b, Value a) { b = b + a; return RPNProgram::NONE; }
+    static RPNProgram::Error sub(Value &b, Value a) { b = b - a; return RPNProgram::NONE; }
+    static RPNProgram::Error mul(Value &b, Value a) { b = b * a; return RPNProgram::NONE; }
+    static RPNProgram::Error div(Value &b, Value a) { b = b / a; return RPNProgram::NONE; }
+
+    // The shortest form that reads back as the same double.
+    static void print(std::ostream &out, Value value)
+    {
+        std::ostringstream text;
+        for (int precision = 15; precision <= 17; ++precision)
+        {
+            text.str("");
+            text.precision(precision);
+            text << value;
+            if (precision == 17 || std::strtod(text.str().c_str(), NULL) == value)
+                break;
+        }
+        out << text.str();
+    }
+};
+
+struct Int64Policy
+{
+    typedef long long Value;
+
+    static const char *name() { return "int64"; }
+    static Value digit(unsigned int digit) { return digit; }
+    static RPNProgram::Error constant(float, Value &) { return RPNProgram::INEXACT; }
+    static RPNProgram::Error add(Value &b, Value a) { return __builtin_add_overflow(b, a, &b) ? RPNProgram::OVERFLOW : RPNProgram::NONE; }
+    static RPNProgram::Error sub(Value &b, Value a) { return __builtin_sub_overflow(b, a, &b) ? RPNProgram::OVERFLOW : RPNProgram::NONE; }
+    static RPNProgram::Error mul(Value &b, Value a) { return __builtin_mul_overflow(b, a, &b) ? RPNProgram::OVERFLOW : RPNProgram::NONE; }
+
+    static RPNProgram::Error div(Value &b, Value a)
+    {
+        if (a == 0)
+            return RPNProgram::DIVISION_BY_ZERO;
+        if (a == -1)
+        {
+            if (b == LLONG_MIN)
+                return RPNProgram::OVERFLOW;
+            b = -b;
+            return RPNProgram::NONE;
+        }
+        if (b % a != 0)
+            return RPNProgram::INEXACT;
+        b /= a;
+        return RPNProgram::NONE;
+    }
+
+    static void print(std::ostream &out, Value value) { out << value; }
+};
+
+// Exact fractions of two 64-bit integers, kept in lowest terms with a
+// positive denominator. Every operation works on 128-bit integers and
+// fails with OVERFLOW only if the reduced result does not fit back.
+struct RationalPolicy
+{
+    struct Value
+    {
+        long long numerator;
+        long long denominator;
+    };
+
+    static const char *name() { return "rational"; }
+
+    static Value digit(unsigned int digit)
+    {
+        Value value = { static_cast<long long>(digit), 1 };
+        return value;
+    }
+
+    static RPNProgram::Error constant(float, Value &) { return RPNProgram::INEXACT; }
+
+    static RPNProgram::Error add(Value &b, Value a)
+    {
+        return reduce(static_cast<__int128>(b.numerator) * a.denominator + static_cast<__int128>(a.numerator) * b.denominator,
+            static_cast<__int128>(b.denominator) * a.denominator, b);
+    }
+
+    static RPNProgram::Error sub(Value &b, Value a)
+    {
+        return reduce(static_cast<__int128>(b.numerator) * a.denominator - static_cast<__int128>(a.numerator) * b.denominator,
+            static_cast<__int128>(b.denominator) * a.denominator, b);
+    }
+
+    static RPNProgram::Error mul(Value &b, Value a)
+    {
+        return reduce(static_cast<__int128>(b.numerator) * a.numerator,
+            static_cast<__int128>(b.denominator) * a.denominator, b);
+    }
+
+    static RPNProgram::Error div(Value &b, Value a)
+    {
+        if (a.numerator == 0)
+            return RPNProgram::DIVISION_BY_ZERO;
+        return reduce(static_cast<__int128>(b.numerator) * a.denominator,
+            static_cast<__int128>(b.denominator) * a.numerator, b);
+    }
+
+    static void print(std::ostream &out, const Value &value)
+    {
+        out << value.numerator;
+        if (value.denominator != 1)
+            out << '/' << value.denominator;
+    }
+
+private:
+    // Built from 64-bit parts, both parts stay below 2^127 in magnitude, so
+    // negating them cannot overflow.
+    static RPNProgram::Error reduce(__int128 numerator, __int128 denominator, Value &result)
+    {
+        if (denominator < 0)
+        {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+        unsigned __int128 a = numerator < 0 ? -numerator : numerator;
+        unsigned __int128 b = denominator;
+        while (b != 0)
+        {
+            unsigned __int128 r = a % b;
+            a = b;
+            b = r;
+        }
+        if (a > 1)
+        {
+            numerator /= static_cast<__int128>(a);
+            denominator /= static_cast<__int128>(a);
+        }
+        const __int128 max = 0x7fffffffffffffffLL;
+        if (numerator > max || numerator < -max - 1 || denominator > max)
+            return RPNProgram::OVERFLOW;
+        result.numerator = static_cast<long long>(numerator);
+        result.denominator = static_cast<long long>(denominator);
+        return RPNProgram::NONE;
+    }
+};
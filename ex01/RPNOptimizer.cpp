@@ -0,0 +1,231 @@
+#include "RPNOptimizer.hpp"
+
+#include <cstring>
+
+static const unsigned int ONE = 0x3f800000;
+static const unsigned int NEGATIVE_ZERO = 0x80000000;
+
+static unsigned int bitsOf(float value)
+{
+    unsigned int bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static RPNProgram::Instruction instruction(unsigned char op, unsigned short operand)
+{
+    RPNProgram::Instruction result;
+    result.op = op;
+    result.operand = operand;
+    return result;
+}
+
+static float fold(unsigned char op, float b, float a)
+{
+    switch (op)
+    {
+        case RPNProgram::ADD:
+            return b + a;
+        case RPNProgram::SUB:
+            return b - a;
+        case RPNProgram::MUL:
+            return b * a;
+        default:
+            return b / a;
+    }
+}
+
+int RPNOptimizer::intern(const Node &node)
+{
+    Key key(node.op, node.op == RPNProgram::PUSH ? bitsOf(node.value) : node.operand, node.left, node.right);
+    std::map<Key, int>::iterator found = _index.find(key);
+    if (found != _index.end())
+        return found->second;
+    _nodes.push_back(node);
+    _index.insert(std::make_pair(key, static_cast<int>(_nodes.size() - 1)));
+    return static_cast<int>(_nodes.size() - 1);
+}
+
+int RPNOptimizer::constant(float value)
+{
+    Node node = { RPNProgram::PUSH, 0, value, -1, -1 };
+    return intern(node);
+}
+
+int RPNOptimizer::variable(unsigned short index)
+{
+    Node node = { RPNProgram::LOAD, index, 0, -1, -1 };
+    return intern(node);
+}
+
+int RPNOptimizer::combine(unsigned char op, int left, int right)
+{
+    Node l = _nodes[left];
+    Node r = _nodes[right];
+
+    if (l.op == RPNProgram::PUSH && r.op == RPNProgram::PUSH)
+        return constant(fold(op, l.value, r.value));
+    if (r.op == RPNProgram::PUSH)
+    {
+        unsigned int bits = bitsOf(r.value);
+        if ((op == RPNProgram::MUL || op == RPNProgram::DIV) && bits == ONE)
+            return left;
+        if ((op == RPNProgram::SUB && bits == 0) || (op == RPNProgram::ADD && bits == NEGATIVE_ZERO))
+            return left;
+    }
+    if (l.op == RPNProgram::PUSH)
+    {
+        unsigned int bits = bitsOf(l.value);
+        if ((op == RPNProgram::MUL && bits == ONE) || (op == RPNProgram::ADD && bits == NEGATIVE_ZERO))
+            return right;
+    }
+    Node node = { op, 0, 0, left, right };
+    return intern(node);
+}
+
+size_t RPNOptimizer::optimize(RPNProgram &program)
+{
+    if (!program.ok())
+        return 0;
+    _nodes.clear();
+    _index.clear();
+
+    // Rebuild the DAG, counting the nodes the program evaluates now.
+    std::vector<int> stack;
+    std::vector<int> temporaries(program.temporaries());
+    size_t evaluated = 0;
+    for (size_t i = 0; i < program.size(); ++i)
+    {
+        const RPNProgram::Instruction &current = program._code[i];
+        switch (current.op)
+        {
+            case RPNProgram::PUSH:
+                stack.push_back(constant(current.operand));
+                break;
+            case RPNProgram::CONST:
+                stack.push_back(constant(program._constants[current.operand]));
+                break;
+            case RPNProgram::LOAD:
+                stack.push_back(variable(current.operand));
+                break;
+            case RPNProgram::FETCH:
+                stack.push_back(temporaries[current.operand]);
+                break;
+            case RPNProgram::STORE:
+                temporaries[current.operand] = stack.back();
+                continue;
+            default:
+            {
+                int right = stack.back();
+                stack.pop_back();
+                stack.back() = combine(current.op, stack.back(), right);
+                break;
+            }
+        }
+        ++evaluated;
+    }
+
+    // Children are interned before their parents, so every node the root
+    // reaches has a smaller index than the root.
+    int root = stack.back();
+    std::vector<int> uses(root + 1, 0);
+    uses[root] = 1;
+    for (int id = root; id >= 0; --id)
+    {
+        if (uses[id] > 0 && _nodes[id].left >= 0)
+        {
+            ++uses[_nodes[id].left];
+            ++uses[_nodes[id].right];
+        }
+    }
+    return emit(root, uses, evaluated, program);
+}
+
+// Writes the DAG back as code. An operator node used more than once gets a
+// temporary: its first use computes and stores it, the others fetch it.
+// Constants and variables are cheap enough to push again. The code replaces
+// the program's only if it evaluates fewer nodes.
+size_t RPNOptimizer::emit(int root, const std::vector<int> &uses, size_t before, RPNProgram &program)
+{
+    std::vector<int> temporary(root + 1, -1);
+    size_t temporaries = 0;
+    for (int id = 0; id <= root; ++id)
+    {
+        if (uses[id] > 1 && _nodes[id].left >= 0)
+            temporary[id] = static_cast<int>(temporaries++);
+    }
+    if (temporaries > 65535)
+        return 0;
+
+    std::vector<RPNProgram::Instruction> code;
+    std::vector<float> constants;
+    std::map<unsigned int, unsigned short> constantIndex;
+    std::vector<char> stored(root + 1, 0);
+    // (node, children emitted so far)
+    std::vector<std::pair<int, int> > frames(1, std::make_pair(root, 0));
+    while (!frames.empty())
+    {
+        int id = frames.back().first;
+        int state = frames.back().second;
+        const Node node = _nodes[id];
+        if (state == 0 && stored[id])
+            code.push_back(instruction(RPNProgram::FETCH, static_cast<unsigned short>(temporary[id])));
+        else if (node.op == RPNProgram::LOAD)
+            code.push_back(instruction(RPNProgram::LOAD, node.operand));
+        else if (node.op == RPNProgram::PUSH)
+        {
+            unsigned int bits = bitsOf(node.value);
+            if (node.value >= 0 && node.value <= 9 && node.value == static_cast<int>(node.value) && bits != NEGATIVE_ZERO)
+                code.push_back(instruction(RPNProgram::PUSH, static_cast<unsigned short>(node.value)));
+            else
+            {
+                std::map<unsigned int, unsigned short>::iterator found = constantIndex.find(bits);
+                if (found == constantIndex.end())
+                {
+                    if (constants.size() > 65535)
+                        return 0;
+                    constants.push_back(node.value);
+                    found = constantIndex.insert(std::make_pair(bits, static_cast<unsigned short>(constants.size() - 1))).first;
+                }
+                code.push_back(instruction(RPNProgram::CONST, found->second));
+            }
+        }
+        else if (state < 2)
+        {
+            frames.back().second = state + 1;
+            frames.push_back(std::make_pair(state == 0 ? node.left : node.right, 0));
+            continue;
+        }
+        else
+        {
+            code.push_back(instruction(node.op, 0));
+            if (temporary[id] >= 0)
+            {
+                code.push_back(instruction(RPNProgram::STORE, static_cast<unsigned short>(temporary[id])));
+                stored[id] = 1;
+            }
+        }
+        frames.pop_back();
+    }
+
+    size_t evaluated = 0;
+    size_t depth = 0;
+    size_t maxDepth = 0;
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (code[i].op == RPNProgram::STORE)
+            continue;
+        ++evaluated;
+        if (code[i].op >= RPNProgram::ADD)
+            --depth;
+        else if (++depth > maxDepth)
+            maxDepth = depth;
+    }
+    if (evaluated >= before)
+        return 0;
+    program._code.swap(code);
+    program._constants.swap(constants);
+    program._temporaries = temporaries;
+    program._maxDepth = maxDepth;
+    return before - evaluated;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <cstddef>
+#include "RPNProgram.hpp"
+
+// Rewrites a compiled program so that later runs do less work:
+//
+//   - subtrees of constants are folded, with the float arithmetic the
+//     evaluators use, so the results are the same bits;
+//   - x*1, 1*x, x/1 and x-0 become x. So does x+(-0), but not x+0: when x
+//     is -0 that gives +0;
+//   - identical subtrees are computed once, kept in a temporary and fetched
+//     where they are used again.
+//
+// The nodes removed are the ones the program no longer evaluates: a folded
+// subtree is left as one constant, a repeated subtree as one FETCH.
+class RPNOptimizer
+{
+    public:
+        // Rewrites an ok() program in place. Returns the number of nodes
+        // removed; 0 leaves the program unchanged. Optimizing the result
+        // again removes nothing.
+        size_t optimize(RPNProgram &program);
+
+    private:
+        struct Node
+        {
+            unsigned char op;       // PUSH (any constant), LOAD or an operator
+            unsigned short operand; // LOAD: the variable
+            float value;            // PUSH: the constant
+            int left;
+            int right;
+        };
+
+        // (op, constant bits or variable, left, right)
+        typedef std::tuple<unsigned char, unsigned int, int, int> Key;
+
+        int constant(float value);
+        int variable(unsigned short index);
+        int combine(unsigned char op, int left, int right);
+        int intern(const Node &node);
+        size_t emit(int root, const std::vector<int> &uses, size_t before, RPNProgram &program);
+
+        std::vector<Node> _nodes;
+        std::map<Key, int> _index;
+};
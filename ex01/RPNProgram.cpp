@@ -0,0 +1,196 @@
+#include "RPNProgram.hpp"
+
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+const size_t RPNProgram::MAX_VARIABLES;
+
+RPNProgram::RPNProgram()
+{
+    _maxDepth = 0;
+    _temporaries = 0;
+    _error = UNBALANCED;
+}
+
+RPNProgram::RPNProgram(const std::string &expression, bool variables)
+{
+    compile(expression, variables);
+}
+
+void RPNProgram::compile(const std::string &expression, bool variables)
+{
+    compile(expression.data(), expression.data() + expression.size(), variables);
+}
+
+void RPNProgram::compile(const char *begin, const char *end, bool variables)
+{
+    size_t depth = 0;
+    const char *p = begin;
+
+    _code.clear();
+    _variables.clear();
+    _constants.clear();
+    _temporaries = 0;
+    _maxDepth = 0;
+    _error = NONE;
+    while (true)
+    {
+        while (p != end && std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if (p == end)
+            break;
+        const char *token = p;
+        while (p != end && !std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        _error = compileToken(token, p, depth, variables);
+        if (_error != NONE)
+            return;
+        if (depth > _maxDepth)
+            _maxDepth = depth;
+    }
+    if (depth != 1)
+        _error = UNBALANCED;
+}
+
+// Numbers are read the way std::stoi reads them: an optional sign, then
+// digits, ignoring whatever follows ("5abc" is 5). Anything stoi would throw
+// on is NOT_A_NUMBER.
+RPNProgram::Error RPNProgram::compileToken(const char *begin, const char *end, size_t &depth, bool variables)
+{
+    Instruction instruction;
+
+    if (end - begin == 1 && std::strchr("+-*/", *begin))
+    {
+        if (depth < 2)
+            return UNDERFLOW;
+        instruction.op = *begin == '+' ? ADD : *begin == '-' ? SUB : *begin == '*' ? MUL : DIV;
+        instruction.operand = 0;
+        _code.push_back(instruction);
+        --depth;
+        return NONE;
+    }
+
+    if (variables && compileVariable(begin, end))
+    {
+        ++depth;
+        return NONE;
+    }
+
+    const char *p = begin;
+    bool negative = false;
+    if (*p == '+' || *p == '-')
+        negative = *p++ == '-';
+    if (p == end || !std::isdigit(static_cast<unsigned char>(*p)))
+        return NOT_A_NUMBER;
+    unsigned long limit = static_cast<unsigned long>(INT_MAX) + (negative ? 1 : 0);
+    unsigned long magnitude = 0;
+    for (; p != end && std::isdigit(static_cast<unsigned char>(*p)); ++p)
+    {
+        magnitude = magnitude * 10 + static_cast<unsigned long>(*p - '0');
+        if (magnitude > limit)
+            return NOT_A_NUMBER;
+    }
+    if ((negative && magnitude != 0) || magnitude > 9 || std::memchr(begin, '.', end - begin))
+        return OUT_OF_RANGE;
+    instruction.op = PUSH;
+    instruction.operand = static_cast<unsigned short>(magnitude);
+    _code.push_back(instruction);
+    ++depth;
+    return NONE;
+}
+
+// Emits a LOAD if the token is an identifier.
+bool RPNProgram::compileVariable(const char *begin, const char *end)
+{
+    if (!std::isalpha(static_cast<unsigned char>(*begin)) && *begin != '_')
+        return false;
+    for (const char *p = begin; p != end; ++p)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(*p)) && *p != '_')
+            return false;
+    }
+    size_t index = 0;
+    while (index < _variables.size() && _variables[index].compare(0, std::string::npos, begin, end - begin) != 0)
+        ++index;
+    if (index == MAX_VARIABLES)
+        return false;
+    if (index == _variables.size())
+        _variables.push_back(std::string(begin, end));
+    Instruction instruction;
+    instruction.op = LOAD;
+    instruction.operand = static_cast<unsigned short>(index);
+    _code.push_back(instruction);
+    return true;
+}
+
+RPNProgram::Error RPNProgram::error() const
+{
+    return _error;
+}
+
+bool RPNProgram::ok() const
+{
+    return _error == NONE;
+}
+
+const RPNProgram::Instruction *RPNProgram::code() const
+{
+    return _code.empty() ? NULL : &_code[0];
+}
+
+size_t RPNProgram::size() const
+{
+    return _code.size();
+}
+
+size_t RPNProgram::maxDepth() const
+{
+    return _maxDepth;
+}
+
+const std::vector<std::string> &RPNProgram::variables() const
+{
+    return _variables;
+}
+
+const std::vector<float> &RPNProgram::constants() const
+{
+    return _constants;
+}
+
+size_t RPNProgram::temporaries() const
+{
+    return _temporaries;
+}
+
+std::string RPNProgram::listing() const
+{
+    static const char operators[] = "+-*/";
+    std::string text;
+    char token[32];
+
+    for (size_t i = 0; i < _code.size(); ++i)
+    {
+        const Instruction &instruction = _code[i];
+        if (i > 0)
+            text += ' ';
+        if (instruction.op == PUSH || instruction.op == FETCH || instruction.op == STORE)
+        {
+            std::snprintf(token, sizeof(token), instruction.op == PUSH ? "%u" : instruction.op == FETCH ? "t%u" : "t%u=",
+                static_cast<unsigned int>(instruction.operand));
+            text += token;
+        }
+        else if (instruction.op == LOAD)
+            text += _variables[instruction.operand];
+        else if (instruction.op == CONST)
+        {
+            std::snprintf(token, sizeof(token), "%g", static_cast<double>(_constants[instruction.operand]));
+            text += token;
+        }
+        else
+            text += operators[instruction.op - ADD];
+    }
+    return text;
+}
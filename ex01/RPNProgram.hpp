@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// An RPN expression compiled once into a flat bytecode array, so that it can
+// be evaluated any number of times without being tokenized again.
+//
+// Every error RPN reports depends only on the tokens, never on the values,
+// so compile() finds them all up front. A program that failed keeps the
+// code for the tokens before the failing one: running it leaves the stack
+// exactly as the token-by-token evaluator left it when it stopped.
+//
+// With variables allowed, a token that is an identifier ([A-Za-z_][A-Za-z0-9_]*)
+// names a variable instead of being an invalid number. Variables are
+// numbered in order of first use; variables() lists their names.
+//
+// RPNOptimizer may rewrite a program: it adds constants that are not digits
+// (CONST) and temporaries that hold a value computed once and used again
+// (STORE copies the top of the stack into one, FETCH pushes it back).
+class RPNProgram
+{
+    public:
+        enum Opcode
+        {
+            PUSH,   // push the digit in operand
+            LOAD,   // push the value of variable number operand
+            CONST,  // push constants()[operand]
+            FETCH,  // push temporary number operand
+            STORE,  // copy the top of the stack into temporary number operand
+            ADD,
+            SUB,
+            MUL,
+            DIV
+        };
+
+        // The values match the numbers RPN prints ("Error 1" ...). The last
+        // three only come from running a program with exact numbers; see
+        // RPNNumbers.hpp.
+        enum Error
+        {
+            NONE = 0,
+            UNDERFLOW = 1,      // an operator with fewer than two operands
+            DIVISION_BY_ZERO = 2,
+            OUT_OF_RANGE = 3,   // a number outside 0-9, or with a '.'
+            NOT_A_NUMBER = 4,
+            UNBALANCED = 5,     // not exactly one value left at the end
+            OVERFLOW = 6,
+            INEXACT = 7
+        };
+
+        struct Instruction
+        {
+            unsigned char op;
+            unsigned short operand;
+        };
+
+        RPNProgram();
+        explicit RPNProgram(const std::string &expression, bool variables = false);
+
+        void compile(const std::string &expression, bool variables = false);
+        void compile(const char *begin, const char *end, bool variables = false);
+
+        Error error() const;
+        bool ok() const;
+        const Instruction *code() const;
+        size_t size() const;
+        // Deepest the stack gets while running the program.
+        size_t maxDepth() const;
+        const std::vector<std::string> &variables() const;
+        const std::vector<float> &constants() const;
+        size_t temporaries() const;
+        // The code as space-separated tokens: numbers, variable names, and
+        // "tN=" / "tN" for STORE / FETCH of temporary N.
+        std::string listing() const;
+
+    private:
+        friend class RPNOptimizer;
+
+        static const size_t MAX_VARIABLES = 65536;
+
+        Error compileToken(const char *begin, const char *end, size_t &depth, bool variables);
+        bool compileVariable(const char *begin, const char *end);
+
+        std::vector<Instruction> _code;
+        std::vector<std::string> _variables;
+        std::vector<float> _constants;
+        size_t _temporaries;
+        size_t _maxDepth;
+        Error _error;
+};
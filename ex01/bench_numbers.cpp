@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "RPNProgram.hpp"
+#include "RPNEvaluator.hpp"
+#include "BenchTimer.hpp"
+
+// Compiles sets of random expressions once, then evaluates all of them
+// with every numeric policy and reports the speed of each, so the cost of
+// the exact kinds of numbers is known. The first set has no division, which
+// the exact policies often stop at (int64 rejects most quotients), so that
+// all of them run every expression to the end.
+//
+// Usage: bench_numbers [EXPRESSIONS] [TOKENS] [ROUNDS]
+
+// A valid expression of about the given number of tokens. Zeros are rare,
+// so that most divisions mean something to the exact policies.
+static std::string randomExpression(size_t tokens, const std::string &operators)
+{
+    std::string expression;
+    size_t depth = 0;
+
+    for (size_t i = 0; i < tokens || depth > 1; ++i)
+    {
+        if (!expression.empty())
+            expression += ' ';
+        if (depth >= 2 && (i >= tokens || std::rand() % 2 == 0))
+        {
+            expression += operators[std::rand() % operators.size()];
+            --depth;
+        }
+        else
+        {
+            expression += static_cast<char>('0' + (std::rand() % 16 == 0 ? 0 : 1 + std::rand() % 9));
+            ++depth;
+        }
+    }
+    return expression;
+}
+
+template <class Policy>
+static void benchmark(const std::vector<RPNProgram> &programs, size_t tokens, size_t rounds)
+{
+    BasicRPNEvaluator<Policy> evaluator;
+    size_t failed = 0;
+
+    BenchTimer timer;
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (size_t i = 0; i < programs.size(); ++i)
+        {
+            evaluator.run(programs[i]);
+            if (evaluator.error() != RPNProgram::NONE)
+                ++failed;
+        }
+    }
+    double seconds = timer.seconds();
+    double evaluations = static_cast<double>(programs.size() * rounds);
+    std::cout << "  " << std::left << std::setw(10) << Policy::name() << std::right
+        << std::setw(8) << std::fixed << std::setprecision(1) << seconds * 1e9 / evaluations << " ns/eval  "
+        << std::setw(12) << std::setprecision(0) << evaluations / seconds << " evals/s  "
+        << std::setw(12) << evaluations * tokens / seconds << " tokens/s  "
+        << failed / rounds << " failed" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 10000;
+    size_t tokens = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 31;
+    size_t rounds = argc > 3 ? std::strtoul(argv[3], NULL, 10) : 100;
+    if (count == 0 || tokens == 0 || rounds == 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [EXPRESSIONS] [TOKENS] [ROUNDS]" << std::endl;
+        return 1;
+    }
+
+    std::srand(42);
+    const char *sets[] = { "+-*", "+-*/" };
+    for (size_t set = 0; set < 2; ++set)
+    {
+        std::vector<RPNProgram> programs(count);
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            programs[i].compile(randomExpression(tokens, sets[set]));
+            total += programs[i].size();
+        }
+        std::cout << count << " expressions over \"" << sets[set] << "\", " << total / count
+            << " tokens each, " << rounds << " rounds" << std::endl;
+        benchmark<FloatPolicy>(programs, total / count, rounds);
+        benchmark<DoublePolicy>(programs, total / count, rounds);
+        benchmark<Int64Policy>(programs, total / count, rounds);
+        benchmark<RationalPolicy>(programs, total / count, rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "RPN.hpp"
+#include "RPNGenerator.hpp"
+#include "BenchTimer.hpp"
+
+// Measures the in-process path the RPN program takes for one expression:
+// RPN::calculate end to end, then its compile and run halves on their own.
+// Expressions come from RPNGenerator, so their length, stack depth and share
+// of invalid ones are under control. Each stage repeats the whole set until
+// a second has passed.
+//
+// Usage: bench_rpn [EXPRESSIONS] [TOKENS] [DEPTH] [INVALID]
+
+static void report(const char *stage, size_t passes, size_t expressions, size_t tokens, double seconds)
+{
+    double evaluations = static_cast<double>(passes * expressions);
+    std::cout << "  " << std::left << std::setw(16) << stage << std::right
+        << std::setw(8) << std::fixed << std::setprecision(1) << seconds * 1e9 / evaluations << " ns/eval  "
+        << std::setw(12) << std::setprecision(0) << evaluations / seconds << " evals/s  "
+        << std::setw(12) << static_cast<double>(passes * tokens) / seconds << " tokens/s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 10000;
+    RPNGenerator::Options options;
+    options.tokens = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 31;
+    options.depth = argc > 3 ? std::strtoul(argv[3], NULL, 10) : 8;
+    options.invalid = argc > 4 ? std::strtod(argv[4], NULL) : 0.25;
+    options.seed = 42;
+    if (count == 0 || options.tokens == 0 || options.invalid < 0 || options.invalid > 1)
+    {
+        std::cerr << "usage: " << argv[0] << " [EXPRESSIONS] [TOKENS] [DEPTH] [INVALID]" << std::endl;
+        return 1;
+    }
+
+    RPNGenerator generator(options);
+    std::vector<std::string> expressions(count);
+    size_t tokens = 0;
+    size_t invalid = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (generator.next(expressions[i]) != RPNProgram::NONE)
+            ++invalid;
+        tokens += generator.tokens();
+    }
+    std::cout << count << " expressions, " << tokens / count << " tokens each, depth " << options.depth
+        << ", " << invalid << " invalid" << std::endl;
+
+    // RPN::calculate reports errors on std::cout; leave that out of the timing.
+    std::streambuf *stdoutBuffer = std::cout.rdbuf(NULL);
+    RPN rpn;
+    size_t passes = 0;
+    BenchTimer timer;
+    do
+    {
+        for (size_t i = 0; i < count; ++i)
+            rpn.calculate(expressions[i]);
+        ++passes;
+    } while (timer.seconds() < 1);
+    double seconds = timer.seconds();
+    std::cout.rdbuf(stdoutBuffer);
+    std::cout.clear();
+    report("RPN::calculate", passes, count, tokens, seconds);
+
+    std::vector<RPNProgram> programs(count);
+    passes = 0;
+    timer = BenchTimer();
+    do
+    {
+        for (size_t i = 0; i < count; ++i)
+            programs[i].compile(expressions[i]);
+        ++passes;
+    } while (timer.seconds() < 1);
+    report("compile", passes, count, tokens, timer.seconds());
+
+    RPNEvaluator evaluator;
+    passes = 0;
+    timer = BenchTimer();
+    do
+    {
+        for (size_t i = 0; i < count; ++i)
+            evaluator.run(programs[i]);
+        ++passes;
+    } while (timer.seconds() < 1);
+    report("run", passes, count, tokens, timer.seconds());
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <iostream>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "RPN.hpp"
+#include "RPNGenerator.hpp"
+#include "RPNOptimizer.hpp"
+#include "BenchTimer.hpp"
+
+// Feeds RPNGenerator's expressions, and random mutations of them, through
+// every evaluation path and stops at the first disagreement:
+//
+//   - the token-by-token interpreter RPN had before it compiled expressions
+//     is the reference; a generated expression must also fail exactly as
+//     the generator intended;
+//   - RPN::calculate + printResult must print what the reference implies,
+//     on stdout and stderr;
+//   - RPNProgram must find the same error, and RPNEvaluator must compute the
+//     same float bits, before and after RPNOptimizer;
+//   - whenever int64 finishes, rational must reach the same integer.
+//
+// Usage: fuzz_rpn [RUNS] [TOKENS] [DEPTH] [SEED]
+
+static int reference(const std::string &str, float &result)
+{
+    std::istringstream iss(str);
+    std::string token;
+    std::stack<float> stack;
+
+    while (iss >> token)
+    {
+        if (token == "+" || token == "-" || token == "*" || token == "/")
+        {
+            if (stack.size() < 2)
+                return 1;
+            float a = stack.top();
+            stack.pop();
+            float b = stack.top();
+            stack.pop();
+            if (token == "+")
+                stack.push(b + a);
+            else if (token == "-")
+                stack.push(b - a);
+            else if (token == "*")
+                stack.push(b * a);
+            else
+                stack.push(b / a);
+        }
+        else
+        {
+            try
+            {
+                if (std::stoi(token) > 9 || std::stoi(token) < 0 || token.find('.') != std::string::npos)
+                    return 3;
+            }
+            catch (std::exception &e)
+            {
+                return 4;
+            }
+            stack.push(std::stoi(token));
+        }
+    }
+    if (stack.size() != 1)
+        return 5;
+    result = stack.top();
+    return 0;
+}
+
+static bool sameBits(float a, float b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static std::string escape(const std::string &text)
+{
+    std::string escaped;
+    char byte[8];
+
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 32 && c < 127 && c != '\\' && c != '"')
+            escaped += text[i];
+        else
+        {
+            std::snprintf(byte, sizeof(byte), "\\x%02x", c);
+            escaped += byte;
+        }
+    }
+    return escaped;
+}
+
+// Returns what is wrong with RPN's handling of the expression, or NULL.
+static const char *check(const std::string &expression, int expected, std::ostringstream &out, std::ostringstream &err)
+{
+    float value = 0;
+    int error = reference(expression, value);
+    if (expected >= 0 && error != expected)
+        return "the reference disagrees with the generator";
+
+    RPN rpn;
+    out.str("");
+    err.str("");
+    rpn.calculate(expression);
+    rpn.printResult();
+    std::ostringstream wanted;
+    if (error)
+        wanted << "Error " << error << std::endl;
+    else
+        wanted << value << std::endl;
+    if (out.str() != wanted.str() || err.str() != (error ? "Error\n" : ""))
+        return "RPN::calculate printed something else";
+
+    RPNProgram program(expression);
+    if (program.error() != error)
+        return "RPNProgram found another error";
+    if (error)
+        return NULL;
+    RPNEvaluator evaluator;
+    if (!sameBits(evaluator.run(program), value))
+        return "RPNEvaluator computed another value";
+    RPNProgram optimized(program);
+    RPNOptimizer().optimize(optimized);
+    if (!sameBits(evaluator.run(optimized), value))
+        return "the optimized program computed another value";
+
+    BasicRPNEvaluator<Int64Policy> integers;
+    BasicRPNEvaluator<RationalPolicy> rationals;
+    long long integer = integers.run(program);
+    RationalPolicy::Value rational = rationals.run(program);
+    if (integers.error() == RPNProgram::NONE
+        && (rationals.error() != RPNProgram::NONE || rational.numerator != integer || rational.denominator != 1))
+        return "int64 and rational disagree";
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+    RPNGenerator::Options options;
+    options.tokens = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 15;
+    options.depth = argc > 3 ? std::strtoul(argv[3], NULL, 10) : 8;
+    options.invalid = 0.5;
+    options.seed = argc > 4 ? std::strtoull(argv[4], NULL, 10) : 42;
+    RPNGenerator generator(options);
+
+    // RPN prints to std::cout and std::cerr; catch both.
+    std::ostringstream out;
+    std::ostringstream err;
+    std::streambuf *stdoutBuffer = std::cout.rdbuf(out.rdbuf());
+    std::streambuf *stderrBuffer = std::cerr.rdbuf(err.rdbuf());
+
+    unsigned long outcomes[8] = { 0 };
+    unsigned long mutated = 0;
+    std::string expression;
+    const char *failure = NULL;
+    BenchTimer timer;
+    unsigned long run = 0;
+    for (; run < runs && !failure; ++run)
+    {
+        int expected = generator.next(expression);
+        if (run % 4 == 3)
+        {
+            generator.mutate(expression);
+            expected = -1;
+            ++mutated;
+        }
+        failure = check(expression, expected, out, err);
+        float value;
+        ++outcomes[reference(expression, value)];
+    }
+    double seconds = timer.seconds();
+    std::cout.rdbuf(stdoutBuffer);
+    std::cerr.rdbuf(stderrBuffer);
+
+    if (failure)
+    {
+        std::cout << "FAIL after " << run << " runs: " << failure << std::endl
+            << "  expression: \"" << escape(expression) << "\"" << std::endl;
+        return 1;
+    }
+    std::cout << run << " expressions (" << mutated << " mutated) in " << seconds << " s, "
+        << static_cast<unsigned long>(run / seconds) << " expressions/s" << std::endl;
+    std::cout << "  valid " << outcomes[0];
+    for (int error = 1; error <= 5; ++error)
+    {
+        if (error != RPNProgram::DIVISION_BY_ZERO)
+            std::cout << ", Error " << error << " " << outcomes[error];
+    }
+    std::cout << std::endl;
+    return 0;
+}
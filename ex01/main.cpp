@@ -1,10 +1,145 @@
+#include <fstream>
+#include <cstdlib>
+#include <thread>
 #include "RPN.hpp"
+#include "RPNBatch.hpp"
+#include "RPNColumnEvaluator.hpp"
+#include "RPNOptimizer.hpp"
+
+// RPN --batch [-j THREADS] [FILE]: evaluates one expression per line of FILE
+// (stdin if it is missing or "-"). THREADS defaults to 1; 0 uses every core.
+static int runBatch(int ac, char **av)
+{
+    unsigned long threads = 1;
+    std::string input = "-";
+    int i = 2;
+
+    if (i + 1 < ac && std::string(av[i]) == "-j")
+    {
+        char *end;
+        threads = std::strtoul(av[i + 1], &end, 10);
+        if (*av[i + 1] == '\0' || *end != '\0')
+            throw std::string("Usage: RPN --batch [-j threads] [file]");
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        i += 2;
+    }
+    if (i < ac)
+        input = av[i++];
+    if (i != ac)
+        throw std::string("Usage: RPN --batch [-j threads] [file]");
+
+    RPNBatch batch(static_cast<unsigned int>(threads));
+    if (input == "-")
+        batch.run(std::cin, std::cout);
+    else
+    {
+        std::ifstream file(input.c_str());
+        if (!file)
+            throw std::string("Could not open " + input);
+        batch.run(file, std::cout);
+    }
+    return 0;
+}
+
+// RPN --columns EXPRESSION [FILE]: evaluates an expression over variables
+// once per row of a table (stdin if FILE is missing or "-"). The table's
+// first line names its columns.
+static int runColumns(int ac, char **av)
+{
+    if (ac < 3 || ac > 4)
+        throw std::string("Usage: RPN --columns expression [file]");
+    RPNProgram program(av[2], true);
+    if (!program.ok())
+        throw std::string("Invalid expression");
+    RPNOptimizer().optimize(program);
+
+    RPNColumnEvaluator evaluator;
+    std::string input = ac == 4 ? av[3] : "-";
+    if (input == "-")
+        evaluator.evaluateTable(program, std::cin, std::cout);
+    else
+    {
+        std::ifstream file(input.c_str());
+        if (!file)
+            throw std::string("Could not open " + input);
+        evaluator.evaluateTable(program, file, std::cout);
+    }
+    return 0;
+}
+
+// RPN --optimize EXPRESSION: prints the program the optimizer makes of an
+// expression (variables allowed) and how many nodes it removed.
+static int runOptimize(int ac, char **av)
+{
+    if (ac != 3)
+        throw std::string("Usage: RPN --optimize expression");
+    RPNProgram program(av[2], true);
+    if (!program.ok())
+        throw std::string("Invalid expression");
+    size_t removed = RPNOptimizer().optimize(program);
+    std::cout << program.listing() << std::endl;
+    std::cout << "removed " << removed << " nodes" << std::endl;
+    return 0;
+}
+
+// RPN --numbers float|double|int64|rational EXPRESSION: evaluates with the
+// given kind of numbers (see RPNNumbers.hpp), reporting errors like the
+// default mode. The exact kinds add Error 2 for a division by zero, Error 6
+// for an overflow and, for int64, Error 7 for a quotient that is not an
+// integer.
+template <class Policy>
+static int calculateWith(const char *expression)
+{
+    RPNProgram program(expression);
+    BasicRPNEvaluator<Policy> evaluator;
+    typename Policy::Value result = typename Policy::Value();
+    RPNProgram::Error error = program.error();
+    if (program.ok())
+    {
+        result = evaluator.run(program);
+        error = evaluator.error();
+    }
+    if (error != RPNProgram::NONE)
+    {
+        std::cout << "Error " << error << std::endl;
+        std::cerr << "Error" << std::endl;
+        return 0;
+    }
+    Policy::print(std::cout, result);
+    std::cout << std::endl;
+    return 0;
+}
+
+static int runNumbers(int ac, char **av)
+{
+    if (ac != 4)
+        throw std::string("Usage: RPN --numbers float|double|int64|rational expression");
+    std::string numbers = av[2];
+    if (numbers == FloatPolicy::name())
+        return calculateWith<FloatPolicy>(av[3]);
+    if (numbers == DoublePolicy::name())
+        return calculateWith<DoublePolicy>(av[3]);
+    if (numbers == Int64Policy::name())
+        return calculateWith<Int64Policy>(av[3]);
+    if (numbers == RationalPolicy::name())
+        return calculateWith<RationalPolicy>(av[3]);
+    throw std::string("Unknown numbers " + numbers);
+}
 
 int main(int ac, char **av)
 {
     RPN rpn;
     try
     {
+        if (ac >= 2 && std::string(av[1]) == "--batch")
+            return runBatch(ac, av);
+        if (ac >= 2 && std::string(av[1]) == "--columns")
+            return runColumns(ac, av);
+        if (ac >= 2 && std::string(av[1]) == "--optimize")
+            return runOptimize(ac, av);
+        if (ac >= 2 && std::string(av[1]) == "--numbers")
+            return runNumbers(ac, av);
         if (ac != 2)
         {
             throw std::string("Usage: RPN [expression]");
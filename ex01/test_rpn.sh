@@ -97,6 +97,112 @@ for ((i=0; i<10; i++)); do
 done
 rm -f tmp_error
 
+# --------- BATCH MODE -----------
+
+echo "=== Running Batch Tests ==="
+
+batch_input=$'8 9 * 9 - 9 - 9 - 4 - 1 +\n1 2 + +\n\n7 7 * 7 -\n2 a +\n1 2 * 2 / 2 * 2 4 - +'
+batch_expected=$'42\nError\nError\n42\nError\n0'
+for threads in 1 4; do
+	output=$(echo "$batch_input" | $PROGRAM --batch -j $threads)
+	if [[ "$output" == "$batch_expected" ]]; then
+		print_result 0 "Batch with $threads thread(s) gives one line per expression, in order"
+	else
+		print_result 1 "Batch with $threads thread(s) => got '$output'"
+	fi
+done
+
+for ((n=0; n<2000; n++)); do
+	generate_random_expr
+done > tmp_batch
+$PROGRAM --batch -j 1 tmp_batch > tmp_batch_1
+$PROGRAM --batch -j 4 < tmp_batch > tmp_batch_4
+if [[ $(wc -l < tmp_batch_1) -eq 2000 ]] && cmp -s tmp_batch_1 tmp_batch_4; then
+	print_result 0 "Batch of 2000 random expressions matches across thread counts"
+else
+	print_result 1 "Batch of 2000 random expressions differs across thread counts"
+fi
+rm -f tmp_batch tmp_batch_1 tmp_batch_4
+
+# --------- COLUMN MODE -----------
+
+echo "=== Running Column Tests ==="
+
+table=$'x y z\n1 2 3\n4 5\n0.5 0.25 1e3\n7 0 1\n2 2 2x'
+output=$(echo "$table" | $PROGRAM --columns "x y * 3 + z /")
+expected=$'1.66667\nError\n0.003125\n3\nError'
+if [[ "$output" == "$expected" ]]; then
+	print_result 0 "Columns evaluate 'x y * 3 + z /' per row"
+else
+	print_result 1 "Columns 'x y * 3 + z /' => got '$output'"
+fi
+
+for expr in "x q +" "x +" "x 2.5 *"; do
+	echo "$table" | $PROGRAM --columns "$expr" >/dev/null 2>tmp_error
+	if [[ -s tmp_error ]]; then
+		print_result 0 "Columns reject '$expr'"
+	else
+		print_result 1 "Columns accepted '$expr'"
+	fi
+done
+rm -f tmp_error
+
+# --------- OPTIMIZER -----------
+
+echo "=== Running Optimizer Tests ==="
+
+declare -A optimized
+optimized["x y + x y + * 2 3 * +"]=$'x y + t0= t0 * 6 +\nremoved 4 nodes'
+optimized["x 1 * 0 - 1 /"]=$'x\nremoved 6 nodes'
+optimized["x 0 +"]=$'x 0 +\nremoved 0 nodes'
+optimized["0 1 - 0 * x +"]=$'x\nremoved 6 nodes'
+
+for expr in "${!optimized[@]}"; do
+	output=$($PROGRAM --optimize "$expr")
+	if [[ "$output" == "${optimized[$expr]}" ]]; then
+		print_result 0 "Optimize '$expr' => $(echo "$output" | head -1)"
+	else
+		print_result 1 "Optimize '$expr' => got '$output'"
+	fi
+done
+
+output=$(echo "$table" | $PROGRAM --columns "x y * 3 + z / x y * 3 + z / - 1 *")
+if [[ "$output" == $'0\nError\n0\n0\nError' ]]; then
+	print_result 0 "Columns give the same results after optimization"
+else
+	print_result 1 "Columns after optimization => got '$output'"
+fi
+
+# --------- NUMBER KINDS -----------
+
+echo "=== Running Number Kind Tests ==="
+
+big="9 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 1 +"
+numbers=(
+	"float|$big|3.8742e+08"
+	"double|$big|387420490"
+	"int64|$big|387420490"
+	"rational|$big|387420490"
+	"double|1 3 /|0.3333333333333333"
+	"rational|1 3 / 2 3 / +|1"
+	"rational|5 2 /|5/2"
+	"float|1 0 /|inf"
+	"int64|5 2 /|Error 7"
+	"int64|1 0 /|Error 2"
+	"rational|1 0 /|Error 2"
+	"int64|9 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 *|Error 6"
+	"rational|1 2 + +|Error 1"
+)
+for entry in "${numbers[@]}"; do
+	IFS='|' read -r kind expr expected <<< "$entry"
+	output=$($PROGRAM --numbers "$kind" "$expr" 2>/dev/null)
+	if [[ "$output" == "$expected" ]]; then
+		print_result 0 "$kind: $expr => $output"
+	else
+		print_result 1 "$kind: $expr => got '$output', expected '$expected'"
+	fi
+done
+
 # --------- SUMMARY -----------
 
 echo "=== Summary ==="
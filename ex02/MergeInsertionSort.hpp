@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "PmergeChain.hpp"
+
+// Ford-Johnson merge-insertion sort over any random-access range:
+//
+//     merge_insertion_sort(first, last);
+//     merge_insertion_sort(first, last, comp);
+//     merge_insertion_sort(first, last, comp, proj);
+//
+// It makes close to the fewest comparisons any comparison sort can, at most
+// F(n) = sum over k = 1..n of ceil(log2(3k / 4)), so it pays off when
+// comparing is what costs: long strings, keys looked up elsewhere. Elements
+// are compared as comp(proj(a), proj(b)); proj defaults to the element
+// itself and comp to operator<. The sort is not stable.
+//
+// The algorithm only moves indices. Elements are moved once at the end, each
+// along its permutation cycle, so move-only types work.
+
+struct MergeInsertionIdentity
+{
+    template <class T>
+    T &&operator()(T &&value) const { return (std::forward<T>(value)); }
+};
+
+struct MergeInsertionLess
+{
+    template <class A, class B>
+    bool operator()(A const &a, B const &b) const { return (a < b); }
+};
+
+template <class Iterator, class Compare, class Projection>
+class MergeInsertion
+{
+public:
+    MergeInsertion(Iterator first, size_t size, Compare &comp, Projection &proj)
+        : _first(first), _comp(comp), _proj(proj), _size(size), _arena(5 * size)
+    {
+        _chain.reserve(size);
+    }
+
+    void sort()
+    {
+        for (size_t i = 0; i < _size; ++i)
+            _arena[i] = i;
+        level(0, _size);
+        permute();
+    }
+
+private:
+    bool less(size_t a, size_t b)
+    {
+        return (_comp(_proj(_first[a]), _proj(_first[b])));
+    }
+
+    // One level of merge-insertion, working on indices instead of elements.
+    //
+    // The arena holds every level, one after the other: a level of `size`
+    // items starts at `items` with the indices of its elements, followed by
+    // `size` entries for its result, the positions of those items in sorted
+    // order. The next level starts right after, so the levels need at most
+    // 4 * n entries in all. The last n entries map an element index back to
+    // its position in the current level. The chain is shared by all levels
+    // too: each one is done with it before its caller needs it.
+    //
+    // The recursive call returns the pairs in the order of their larger
+    // elements, so the smaller element of each pair is found directly.
+    void level(size_t items, size_t size)
+    {
+        std::vector<size_t>::iterator item = _arena.begin() + items;
+        std::vector<size_t>::iterator result = item + size;
+
+        if (size <= 1)
+        {
+            std::fill(result, result + size, 0);
+            return;
+        }
+
+        // Pair k is (a, b) = (2k + first[k], 2k + 1 - first[k]); `first`
+        // borrows the result space until the end. A leftover item, if the
+        // size is odd, stays at the last position.
+        size_t half = size / 2;
+        size_t next = items + 2 * size;
+        std::vector<size_t>::iterator first = result;
+
+        for (size_t k = 0; k < half; ++k)
+        {
+            first[k] = less(item[2 * k], item[2 * k + 1]) ? 1 : 0;
+            _arena[next + k] = item[2 * k + first[k]];
+        }
+
+        level(next, half);
+        std::vector<size_t>::iterator order = _arena.begin() + next + half;
+
+        // b1 is smaller than a1, the smallest 'a', so it goes first for free.
+        _chain.clear();
+        _chain.push_back(item[2 * order[0] + 1 - first[order[0]]]);
+        for (size_t k = 0; k < half; ++k)
+            _chain.push_back(item[2 * order[k] + first[order[k]]]);
+
+        // The other 'b' items go in by Jacobsthal groups (1, 3, 5, 11, 21,
+        // ...), each from its highest index down; the leftover item is one
+        // more 'b' with no 'a'. Within group t, everything in the chain before
+        // a_j lies in its first 2^(t + 1) - 1 places, so binary searching that
+        // prefix takes at most t + 1 comparisons.
+        size_t pending = half + size % 2;
+        size_t lower = 1;
+        size_t upper = 3;
+        size_t range = 3;
+
+        while (lower < pending)
+        {
+            for (size_t j = std::min(upper, pending); j > lower; --j)
+            {
+                size_t index = item[j <= half ? 2 * order[j - 1] + 1 - first[order[j - 1]] : size - 1];
+
+                size_t low = 0;
+                size_t high = std::min(range, _chain.size());
+                while (low < high)
+                {
+                    size_t middle = low + (high - low) / 2;
+                    if (less(_chain[middle], index))
+                        low = middle + 1;
+                    else
+                        high = middle;
+                }
+                _chain.insert(low, index);
+            }
+            upper += 2 * lower;
+            lower = upper - 2 * lower;
+            range = 2 * range + 1;
+        }
+
+        std::vector<size_t>::iterator where = _arena.begin() + 4 * _size;
+        for (size_t p = 0; p < size; ++p)
+            where[item[p]] = p;
+        _chain.copy(result);
+        for (size_t p = 0; p < size; ++p)
+            result[p] = where[result[p]];
+    }
+
+    // Moves each element to its place, one permutation cycle at a time,
+    // with a single temporary per cycle. At the top level, positions are
+    // element indices.
+    void permute()
+    {
+        std::vector<size_t>::iterator order = _arena.begin() + _size;
+
+        for (size_t start = 0; start < _size; ++start)
+        {
+            if (order[start] == start)
+                continue;
+            typename std::iterator_traits<Iterator>::value_type held(std::move(_first[start]));
+            size_t to = start;
+            while (order[to] != start)
+            {
+                size_t from = order[to];
+                _first[to] = std::move(_first[from]);
+                order[to] = to;
+                to = from;
+            }
+            _first[to] = std::move(held);
+            order[to] = to;
+        }
+    }
+
+    Iterator _first;
+    Compare &_comp;
+    Projection &_proj;
+    size_t _size;
+    std::vector<size_t> _arena;
+    PmergeChain<std::vector<size_t> > _chain;
+};
+
+template <class Iterator, class Compare, class Projection>
+void merge_insertion_sort(Iterator first, Iterator last, Compare comp, Projection proj)
+{
+    size_t size = static_cast<size_t>(last - first);
+
+    if (size > 1)
+        MergeInsertion<Iterator, Compare, Projection>(first, size, comp, proj).sort();
+}
+
+template <class Iterator, class Compare>
+void merge_insertion_sort(Iterator first, Iterator last, Compare comp)
+{
+    merge_insertion_sort(first, last, comp, MergeInsertionIdentity());
+}
+
+template <class Iterator>
+void merge_insertion_sort(Iterator first, Iterator last)
+{
+    merge_insertion_sort(first, last, MergeInsertionLess(), MergeInsertionIdentity());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+// The main chain of one merge-insertion level: a sequence of positions that
+// grows by insertion at a rank. Entries live in blocks of at most BLOCK, kept
+// in chain order, and a Fenwick tree over the block sizes finds the block
+// holding a rank in O(log blocks). An insertion then shifts the tail of one
+// block instead of the tail of the whole chain; a full block splits in two.
+//
+// All storage is sized once by reserve() and reused by every level, which
+// builds its chain with clear() and push_back() before inserting into it.
+template <class Container>
+class PmergeChain
+{
+public:
+    enum { BLOCK = 1024 };
+
+    PmergeChain();
+
+    // Room for a chain of up to `size` entries.
+    void reserve(size_t size);
+
+    void clear();
+    void push_back(size_t value);
+    void insert(size_t rank, size_t value);
+
+    size_t size() const;
+    size_t operator[](size_t rank) const;
+
+    // Writes the chain, in order, from `out` on.
+    template <class Iterator>
+    void copy(Iterator out) const;
+
+private:
+    void locate(size_t rank, size_t &order, size_t &offset) const;
+    void add(size_t order, size_t delta);
+    void split(size_t order);
+    void rebuild();
+
+    Container _slots;   // BLOCK entries for each block, in allocation order
+    Container _blocks;  // the blocks in chain order
+    Container _sizes;   // the size of each block, in chain order
+    Container _tree;    // Fenwick tree over _sizes
+    size_t _count;      // blocks in use
+    size_t _top;        // highest power of two <= _tree.size() - 1
+    size_t _size;
+};
+
+#include "PmergeChain.tpp"
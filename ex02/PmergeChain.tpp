@@ -0,0 +1,162 @@
+#include <algorithm>
+
+template <class Container>
+PmergeChain<Container>::PmergeChain() : _count(0), _top(0), _size(0) {}
+
+// Every block but the last one filled by push_back() holds at least
+// BLOCK / 2 entries, so a chain of `size` entries never needs more than
+// 2 * size / BLOCK + 1 blocks.
+template <class Container>
+void PmergeChain<Container>::reserve(size_t size)
+{
+    size_t capacity = 2 * size / BLOCK + 2;
+
+    _slots.assign(capacity * BLOCK, 0);
+    _blocks.assign(capacity, 0);
+    _sizes.assign(capacity, 0);
+    _tree.assign(capacity + 1, 0);
+    _top = 1;
+    while (_top * 2 <= capacity)
+        _top *= 2;
+    clear();
+}
+
+template <class Container>
+void PmergeChain<Container>::clear()
+{
+    std::fill(_sizes.begin(), _sizes.begin() + _count, 0);
+    std::fill(_tree.begin(), _tree.end(), 0);
+    _count = 0;
+    _size = 0;
+}
+
+// Fills blocks half way, so that insertions can land anywhere before the
+// first split.
+template <class Container>
+void PmergeChain<Container>::push_back(size_t value)
+{
+    if (_count == 0 || _sizes[_count - 1] == BLOCK / 2)
+    {
+        _blocks[_count] = _count;
+        ++_count;
+    }
+    size_t order = _count - 1;
+    _slots[_blocks[order] * BLOCK + _sizes[order]] = value;
+    ++_sizes[order];
+    add(order, 1);
+    ++_size;
+}
+
+template <class Container>
+void PmergeChain<Container>::insert(size_t rank, size_t value)
+{
+    if (_count == 0)
+    {
+        push_back(value);
+        return;
+    }
+
+    size_t order = _count - 1;
+    size_t offset = _sizes[order];
+    if (rank < _size)
+        locate(rank, order, offset);
+    if (_sizes[order] == BLOCK)
+    {
+        split(order);
+        if (offset >= BLOCK / 2)
+        {
+            ++order;
+            offset -= BLOCK / 2;
+        }
+    }
+
+    typename Container::iterator block = _slots.begin() + _blocks[order] * BLOCK;
+    std::copy_backward(block + offset, block + _sizes[order], block + _sizes[order] + 1);
+    block[offset] = value;
+    ++_sizes[order];
+    add(order, 1);
+    ++_size;
+}
+
+template <class Container>
+size_t PmergeChain<Container>::size() const
+{
+    return (_size);
+}
+
+template <class Container>
+size_t PmergeChain<Container>::operator[](size_t rank) const
+{
+    size_t order;
+    size_t offset;
+
+    locate(rank, order, offset);
+    return (_slots[_blocks[order] * BLOCK + offset]);
+}
+
+template <class Container>
+template <class Iterator>
+void PmergeChain<Container>::copy(Iterator out) const
+{
+    for (size_t order = 0; order < _count; ++order)
+    {
+        typename Container::const_iterator block = _slots.begin() + _blocks[order] * BLOCK;
+        out = std::copy(block, block + _sizes[order], out);
+    }
+}
+
+// Descends the Fenwick tree to the block holding `rank` (< size()).
+template <class Container>
+void PmergeChain<Container>::locate(size_t rank, size_t &order, size_t &offset) const
+{
+    size_t position = 0;
+
+    for (size_t step = _top; step > 0; step /= 2)
+    {
+        if (position + step < _tree.size() && _tree[position + step] <= rank)
+        {
+            position += step;
+            rank -= _tree[position];
+        }
+    }
+    order = position;
+    offset = rank;
+}
+
+template <class Container>
+void PmergeChain<Container>::add(size_t order, size_t delta)
+{
+    for (size_t i = order + 1; i < _tree.size(); i += i & (~i + 1))
+        _tree[i] += delta;
+}
+
+// Moves the upper half of a full block to a new block right after it. Block
+// positions after it change, so the tree is rebuilt; that happens at most
+// once per BLOCK / 2 insertions.
+template <class Container>
+void PmergeChain<Container>::split(size_t order)
+{
+    typename Container::iterator from = _slots.begin() + _blocks[order] * BLOCK;
+    std::copy(from + BLOCK / 2, from + BLOCK, _slots.begin() + _count * BLOCK);
+
+    std::copy_backward(_blocks.begin() + order + 1, _blocks.begin() + _count, _blocks.begin() + _count + 1);
+    std::copy_backward(_sizes.begin() + order + 1, _sizes.begin() + _count, _sizes.begin() + _count + 1);
+    _blocks[order + 1] = _count;
+    _sizes[order] = BLOCK / 2;
+    _sizes[order + 1] = BLOCK / 2;
+    ++_count;
+    rebuild();
+}
+
+template <class Container>
+void PmergeChain<Container>::rebuild()
+{
+    std::fill(_tree.begin(), _tree.end(), 0);
+    std::copy(_sizes.begin(), _sizes.begin() + _count, _tree.begin() + 1);
+    for (size_t i = 1; i < _tree.size(); ++i)
+    {
+        size_t parent = i + (i & (~i + 1));
+        if (parent < _tree.size())
+            _tree[parent] += _tree[i];
+    }
+}
@@ -8,6 +8,7 @@
 #include <regex>
 #include <sstream>
 #include <iomanip>
+#include "MergeInsertionSort.hpp"
 
 class PmergeMe
 {
@@ -18,7 +19,6 @@ public:
     PmergeMe &operator=(PmergeMe const &copy);
 
     void addNumber(std::string token);
-    bool hasDuplicates();
     bool hasError() const;
 
     void sortVector();
@@ -31,20 +31,18 @@ public:
     void fordJohnsonSortVector(std::vector<int>& vec);
     void fordJohnsonSortDeque(std::deque<int>& deq);
 
-    void binaryInsertVector(std::vector<int>& main, std::vector<std::pair<int, int>>& pairs);
-    void binaryInsertDeque(std::deque<int>& main, std::deque<std::pair<int, int>>& pairs);
-
-    std::vector<int> createJacobsthalSequenceVector(size_t size);
-    std::deque<int> createJacobsthalSequenceDeque(size_t size);
-
-    int findPairValueVector(int a, std::vector<std::pair<int, int>>& pairs);
-    int findPairValueDeque(int a, std::deque<std::pair<int, int>>& pairs);
+    static size_t comparisonBound(size_t size);
 
 private:
+    bool less(int a, int b);
+
     std::deque<int> _deque;
     std::vector<int> _vector;
 
     double _vector_time;
     double _deque_time;
+    size_t _comparisons;
+    size_t _vector_comparisons;
+    size_t _deque_comparisons;
     bool _error;
 };
\ No newline at end of file
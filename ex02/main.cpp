@@ -21,13 +21,6 @@ int main(int argc, char **argv)
                 return 1;
         }
 
-        //sorter.hasDuplicates();
-        if (sorter.hasDuplicates())
-        {
-            std::cerr << "Error: Duplicate values detected." << std::endl;
-            return 1;
-        }
-
         sorter.printBefore(argv);
         sorter.sortVector();
         sorter.sortDeque();
@@ -61,13 +54,6 @@ int main(int argc, char **argv)
             return 1;
     }
 
-    //sorter.hasDuplicates();
-    if (sorter.hasDuplicates())
-    {
-        std::cerr << "Error: Duplicate values detected." << std::endl;
-        return 1;
-    }
-
     sorter.printBefore(argv);
     sorter.sortVector();
     sorter.sortDeque();
@@ -0,0 +1,290 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "MergeInsertionSort.hpp"
+
+// Checks merge_insertion_sort against std::sort on std::vector and
+// std::deque ranges: ints (every permutation of the small sizes, random,
+// duplicate-heavy, sorted and reversed input), strings, unique_ptrs sorted
+// through a projection, and custom comparators. The sizes cover 0..64 and
+// both sides of every power of two and every Jacobsthal group boundary up
+// to 2^14. Every sort must also stay within the Ford-Johnson worst case,
+// F(n) = sum over k = 1..n of ceil(log2(3k / 4)) comparisons.
+//
+// Usage: test_merge_insertion [SEED]
+
+namespace
+{
+    // Counts the comparisons the sort makes through it.
+    template <class Compare>
+    struct Counting
+    {
+        Counting(Compare comp, size_t &count) : comp(comp), count(&count) {}
+
+        template <class A, class B>
+        bool operator()(A const &a, B const &b) const
+        {
+            ++*count;
+            return (comp(a, b));
+        }
+
+        Compare comp;
+        size_t *count;
+    };
+
+    struct Record
+    {
+        int key;
+        int id;
+    };
+
+    int failures = 0;
+    unsigned long sorts = 0;
+}
+
+static size_t bound(size_t size)
+{
+    size_t total = 0;
+
+    for (size_t k = 1; k <= size; ++k)
+    {
+        size_t bits = 0;
+        while ((static_cast<size_t>(4) << bits) < 3 * k)
+            ++bits;
+        total += bits;
+    }
+    return (total);
+}
+
+static void fail(const std::string &what, size_t size)
+{
+    if (failures++ < 10)
+        std::cout << "FAIL: " << what << ", n = " << size << std::endl;
+}
+
+// Sorts a copy of values both ways and compares; equal elements of these
+// types cannot be told apart, so the results must match exactly.
+template <class Container, class Compare>
+static void check(Container values, Compare comp, const std::string &what)
+{
+    Container expected(values);
+    size_t comparisons = 0;
+
+    std::sort(expected.begin(), expected.end(), comp);
+    merge_insertion_sort(values.begin(), values.end(), Counting<Compare>(comp, comparisons));
+    ++sorts;
+    if (values != expected)
+        fail(what + ": differs from std::sort", values.size());
+    else if (comparisons > bound(values.size()))
+        fail(what + ": " + std::to_string(comparisons) + " comparisons, over F(n) = "
+            + std::to_string(bound(values.size())), values.size());
+}
+
+template <class Container>
+static void checkInts(std::vector<int> const &values, const std::string &what)
+{
+    check(Container(values.begin(), values.end()), std::less<int>(), what);
+    check(Container(values.begin(), values.end()), std::greater<int>(), what + ", descending");
+}
+
+// Sizes 0..64, then one below, at and above every power of two and every
+// Jacobsthal group boundary (1, 3, 5, 11, 21, ...) up to 2^14.
+static std::vector<size_t> sizes()
+{
+    std::set<size_t> sizes;
+
+    for (size_t size = 0; size <= 64; ++size)
+        sizes.insert(size);
+    for (size_t power = 1; power <= 16384; power *= 2)
+    {
+        sizes.insert(power - 1);
+        sizes.insert(power);
+        sizes.insert(power + 1);
+    }
+    for (size_t lower = 1, upper = 3; lower <= 16384; upper += 2 * lower, lower = upper - 2 * lower)
+    {
+        sizes.insert(lower - 1);
+        sizes.insert(lower);
+        sizes.insert(lower + 1);
+    }
+    return (std::vector<size_t>(sizes.begin(), sizes.end()));
+}
+
+// Every permutation of 0..n-1 for n up to 8, and of a multiset with
+// repeated values.
+static void checkPermutations()
+{
+    for (int size = 0; size <= 8; ++size)
+    {
+        std::vector<int> values(size);
+        for (int i = 0; i < size; ++i)
+            values[i] = i;
+        do
+            checkInts<std::vector<int> >(values, "permutation");
+        while (std::next_permutation(values.begin(), values.end()));
+    }
+    std::vector<int> values = { 0, 0, 1, 1, 1, 2, 3, 3, 3 };
+    do
+        checkInts<std::deque<int> >(values, "multiset permutation");
+    while (std::next_permutation(values.begin(), values.end()));
+}
+
+static void checkSizes(std::mt19937 &random)
+{
+    std::vector<size_t> all = sizes();
+
+    for (size_t s = 0; s < all.size(); ++s)
+    {
+        size_t size = all[s];
+        std::vector<int> values(size);
+
+        for (size_t i = 0; i < size; ++i)
+            values[i] = static_cast<int>(i);
+        std::shuffle(values.begin(), values.end(), random);
+        checkInts<std::vector<int> >(values, "distinct");
+        checkInts<std::deque<int> >(values, "distinct, deque");
+
+        std::uniform_int_distribution<int> few(0, static_cast<int>(size / 8));
+        for (size_t i = 0; i < size; ++i)
+            values[i] = few(random);
+        checkInts<std::vector<int> >(values, "duplicate-heavy");
+        checkInts<std::deque<int> >(values, "duplicate-heavy, deque");
+
+        std::uniform_int_distribution<int> twoValues(0, 1);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = twoValues(random);
+        checkInts<std::vector<int> >(values, "two values");
+        checkInts<std::vector<int> >(std::vector<int>(size, 7), "all equal");
+
+        for (size_t i = 0; i < size; ++i)
+            values[i] = static_cast<int>(i);
+        checkInts<std::vector<int> >(values, "sorted");
+        checkInts<std::deque<int> >(values, "sorted, deque");
+    }
+}
+
+// Strings sharing long prefixes, so that comparing them is not trivial.
+static void checkStrings(std::mt19937 &random)
+{
+    static const char *const prefixes[] = { "", "btc-", "btc-2011-", "btc-2011-01-" };
+    std::uniform_int_distribution<int> prefix(0, 3);
+    std::uniform_int_distribution<int> digit(0, 9);
+
+    for (size_t size = 0; size <= 2000; size = size * 3 / 2 + 1)
+    {
+        std::vector<std::string> values(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            values[i] = prefixes[prefix(random)];
+            for (int d = digit(random) % 4; d >= 0; --d)
+                values[i] += static_cast<char>('0' + digit(random));
+        }
+        check(values, std::less<std::string>(), "strings");
+        check(std::deque<std::string>(values.begin(), values.end()), std::less<std::string>(), "strings, deque");
+    }
+}
+
+// Move-only elements, compared through a projection: the keys must come out
+// in order and every pointer must still be there exactly once.
+template <class Container>
+static void checkUniquePointers(std::mt19937 &random, const std::string &what)
+{
+    for (size_t size = 0; size <= 3000; size = size * 2 + 1)
+    {
+        std::uniform_int_distribution<int> key(0, static_cast<int>(size / 2));
+        Container values;
+        std::vector<int *> before;
+        for (size_t i = 0; i < size; ++i)
+        {
+            values.push_back(std::unique_ptr<int>(new int(key(random))));
+            before.push_back(values.back().get());
+        }
+
+        size_t comparisons = 0;
+        merge_insertion_sort(values.begin(), values.end(), Counting<std::less<int> >(std::less<int>(), comparisons),
+            [](std::unique_ptr<int> const &pointer) { return (*pointer); });
+        ++sorts;
+
+        std::vector<int *> after;
+        std::vector<int> keys;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            after.push_back(values[i].get());
+            keys.push_back(values[i] ? *values[i] : -1);
+        }
+        std::sort(before.begin(), before.end());
+        std::sort(after.begin(), after.end());
+        if (before != after)
+            fail(what + ": lost or duplicated an element", size);
+        else if (!std::is_sorted(keys.begin(), keys.end()))
+            fail(what + ": keys out of order", size);
+        else if (comparisons > bound(size))
+            fail(what + ": over F(n) comparisons", size);
+    }
+}
+
+// Records ordered by a comparator on a projected field: the keys must match
+// std::sort's and the records must be the same ones.
+static void checkRecords(std::mt19937 &random)
+{
+    for (size_t size = 0; size <= 3000; size = size * 2 + 1)
+    {
+        std::uniform_int_distribution<int> key(-50, 50);
+        std::vector<Record> values(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            values[i].key = key(random);
+            values[i].id = static_cast<int>(i);
+        }
+        std::vector<Record> expected(values);
+        std::sort(expected.begin(), expected.end(), [](Record const &a, Record const &b) { return (a.key > b.key); });
+
+        size_t comparisons = 0;
+        merge_insertion_sort(values.begin(), values.end(), Counting<std::greater<int> >(std::greater<int>(), comparisons),
+            [](Record const &record) { return (record.key); });
+        ++sorts;
+
+        std::vector<int> ids;
+        bool keysMatch = true;
+        for (size_t i = 0; i < size; ++i)
+        {
+            keysMatch = keysMatch && values[i].key == expected[i].key;
+            ids.push_back(values[i].id);
+        }
+        std::sort(ids.begin(), ids.end());
+        for (size_t i = 0; i < size; ++i)
+            keysMatch = keysMatch && ids[i] == static_cast<int>(i);
+        if (!keysMatch)
+            fail("records by key, descending: differs from std::sort", size);
+        else if (comparisons > bound(size))
+            fail("records by key, descending: over F(n) comparisons", size);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long seed = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 42;
+    std::mt19937 random(static_cast<std::mt19937::result_type>(seed));
+
+    checkPermutations();
+    checkSizes(random);
+    checkStrings(random);
+    checkUniquePointers<std::vector<std::unique_ptr<int> > >(random, "unique_ptr");
+    checkUniquePointers<std::deque<std::unique_ptr<int> > >(random, "unique_ptr, deque");
+    checkRecords(random);
+
+    if (failures > 0)
+    {
+        std::cout << failures << " of " << sorts << " sorts failed" << std::endl;
+        return (1);
+    }
+    std::cout << sorts << " sorts match std::sort within F(n) comparisons" << std::endl;
+    return (0);
+}
@@ -15,7 +15,11 @@ VALID_TESTS=(
     "1 2 3 4 5 6"
     "9 8 7 6 5"
     "+10 +5 +3"
+    "3 5 5 5 2 3"
+    "7 7 7 7"
+    "2 1 2 1 2 1 2 1 2"
     "$(shuf -i 1-1000 -n 10)"
+    "$(shuf -r -i 1-20 -n 30)"
 )
 
 # Invalid test cases
@@ -23,7 +27,6 @@ INVALID_TESTS=(
     "-1 2"
     "2147483648"
     "abc 1"
-    "3 5 5 5 2 3"
     "3.14"
     "1e4"
     ""
@@ -49,6 +52,9 @@ run_stress_test() {
     echo -e "\n${GREEN}Running STRESS test with 3000 random numbers...${NC}"
     ARGS=$(shuf -i 1-100000 -n 3000 | tr '\\n' ' ')
     $EXEC $ARGS
+    echo -e "\n${GREEN}Running STRESS test with 3000 random numbers from 1 to 100...${NC}"
+    ARGS=$(shuf -r -i 1-100 -n 3000 | tr '\\n' ' ')
+    $EXEC $ARGS
 }
 
 # Run all tests